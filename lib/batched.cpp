@@ -0,0 +1,284 @@
+#include "batched.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+namespace math
+{
+    static constexpr size_t LANES = BatchedLU::LANES;
+    // Fewer packs per thread are not worth starting it
+    static constexpr size_t MIN_PACKS_PER_THREAD = 4;
+
+    // Calls work(pack) for every pack, splitting them between up to
+    // `threads` threads
+    static void forEachPack(size_t packs, size_t threads, const std::function<void(size_t)> &work)
+    {
+        threads = std::min(threads, std::max<size_t>(packs / MIN_PACKS_PER_THREAD, 1));
+        if (threads <= 1) {
+            for (size_t pack = 0; pack < packs; pack++) {
+                work(pack);
+            }
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        for (size_t id = 0; id < threads; id++) {
+            workers.emplace_back([&, id] {
+                for (size_t pack = packs * id / threads; pack < packs * (id + 1) / threads; pack++) {
+                    work(pack);
+                }
+            });
+        }
+        for (auto &&worker : workers) {
+            worker.join();
+        }
+    }
+
+    BatchedLU::BatchedLU(const std::vector<Matrix> &matrices, size_t threads)
+        : m_size(matrices.empty() ? 0 : matrices[0].m_height), m_count(matrices.size()), m_threads(threads)
+    {
+        for (auto &&matrix : matrices) {
+            if (matrix.m_height != m_size || matrix.m_width != m_size) {
+                throw std::runtime_error("Impossible to LU decompose matrices with such dimensions");
+            }
+        }
+        factorizeAll([&matrices](size_t s) {
+            return matrices[s].m_values.data();
+        });
+    }
+
+    BatchedLU::BatchedLU(size_t size, const vector &matrices, size_t threads)
+        : m_size(size), m_count(size ? matrices.size() / (size * size) : 0), m_threads(threads)
+    {
+        if (m_count * size * size != matrices.size()) {
+            throw std::runtime_error("Impossible to LU decompose matrices with such dimensions");
+        }
+        factorizeAll([&matrices, size](size_t s) {
+            return &matrices[s * size * size];
+        });
+    }
+
+    void BatchedLU::factorizeAll(const std::function<const matrix_value *(size_t s)> &system)
+    {
+        if (!m_threads) {
+            m_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+
+        size_t n = m_size;
+        m_packs = (m_count + LANES - 1) / LANES;
+        m_lu.resize(m_packs * n * n * LANES);
+        m_pivots.resize(m_packs * n * LANES);
+
+        // Each thread interleaves its own packs and factorizes them right
+        // away, while they are still in cache. An exception can't leave a
+        // thread, so each pack just reports.
+        std::vector<char> degenerate(m_packs);
+        forEachPack(m_packs, m_threads, [&](size_t pack) {
+            matrix_value *a = &m_lu[pack * n * n * LANES];
+            for (size_t l = 0; l < LANES; l++) {
+                size_t s = pack * LANES + l;
+                const matrix_value *values = s < m_count ? system(s) : nullptr;
+                for (size_t k = 0; k < n * n; k++) {
+                    a[k * LANES + l] = values ? values[k] : k % (n + 1) == 0;
+                }
+            }
+
+            try {
+                factorize(pack);
+            } catch (const std::runtime_error &) {
+                degenerate[pack] = true;
+            }
+        });
+        if (std::find(degenerate.begin(), degenerate.end(), true) != degenerate.end()) {
+            throw std::runtime_error("Matrix is degenerate");
+        }
+    }
+
+    void BatchedLU::factorize(size_t pack)
+    {
+        size_t n = m_size;
+        matrix_value *a = &m_lu[pack * n * n * LANES];
+        size_t *pivots = &m_pivots[pack * n * LANES];
+        auto at = [a, n](size_t i, size_t j) { return a + (j * n + i) * LANES; };
+        matrix_value inverse[LANES];
+
+        for (size_t k = 0; k < n; k++) {
+            // Each system has its own pivot; the search runs across them
+            // without branches, so it vectorizes too
+            size_t pivot[LANES];
+            matrix_value largest[LANES];
+            for (size_t l = 0; l < LANES; l++) {
+                pivot[l] = k;
+                largest[l] = std::abs(at(k, k)[l]);
+            }
+            for (size_t i = k + 1; i < n; i++) {
+                const matrix_value *column = at(i, k);
+                for (size_t l = 0; l < LANES; l++) {
+                    bool larger = std::abs(column[l]) > largest[l];
+                    largest[l] = larger ? std::abs(column[l]) : largest[l];
+                    pivot[l] = larger ? i : pivot[l];
+                }
+            }
+
+            for (size_t l = 0; l < LANES; l++) {
+                if (largest[l] == 0) {
+                    throw std::runtime_error("Matrix is degenerate");
+                }
+                pivots[k * LANES + l] = pivot[l];
+                if (pivot[l] != k) {
+                    for (size_t j = 0; j < n; j++) {
+                        std::swap(at(k, j)[l], at(pivot[l], j)[l]);
+                    }
+                }
+                inverse[l] = 1 / at(k, k)[l];
+            }
+
+            for (size_t i = k + 1; i < n; i++) {
+                matrix_value *column = at(i, k);
+                for (size_t l = 0; l < LANES; l++) {
+                    column[l] *= inverse[l];
+                }
+            }
+            // Rows below k of a column are contiguous, so each column is
+            // one sweep; a local copy of u tells the compiler it isn't
+            // written to
+            for (size_t j = k + 1; j < n; j++) {
+                matrix_value u[LANES];
+                std::copy_n(at(k, j), LANES, u);
+
+                const matrix_value *m = at(k + 1, k);
+                matrix_value *target = at(k + 1, j);
+                for (size_t i = 0; i < (n - k - 1) * LANES; i += LANES) {
+                    for (size_t l = 0; l < LANES; l++) {
+                        target[i + l] -= m[i + l] * u[l];
+                    }
+                }
+            }
+        }
+    }
+
+    size_t BatchedLU::size() const
+    {
+        return m_size;
+    }
+
+    size_t BatchedLU::count() const
+    {
+        return m_count;
+    }
+
+    void BatchedLU::substitute(size_t pack, matrix_value *x) const
+    {
+        size_t n = m_size;
+        const matrix_value *a = &m_lu[pack * n * n * LANES];
+        const size_t *pivots = &m_pivots[pack * n * LANES];
+        auto at = [a, n](size_t i, size_t j) { return a + (j * n + i) * LANES; };
+
+        for (size_t k = 0; k < n; k++) {
+            for (size_t l = 0; l < LANES; l++) {
+                std::swap(x[k * LANES + l], x[pivots[k * LANES + l] * LANES + l]);
+            }
+        }
+
+        for (size_t k = 0; k < n; k++) {
+            const matrix_value *xk = x + k * LANES;
+            for (size_t i = k + 1; i < n; i++) {
+                const matrix_value *m = at(i, k);
+                matrix_value *xi = x + i * LANES;
+                for (size_t l = 0; l < LANES; l++) {
+                    xi[l] -= m[l] * xk[l];
+                }
+            }
+        }
+
+        for (size_t k = n; k-- > 0;) {
+            matrix_value *xk = x + k * LANES;
+            const matrix_value *d = at(k, k);
+            for (size_t l = 0; l < LANES; l++) {
+                xk[l] /= d[l];
+            }
+            for (size_t i = 0; i < k; i++) {
+                const matrix_value *u = at(i, k);
+                matrix_value *xi = x + i * LANES;
+                for (size_t l = 0; l < LANES; l++) {
+                    xi[l] -= u[l] * xk[l];
+                }
+            }
+        }
+    }
+
+    void BatchedLU::solveAll(
+        const std::function<const matrix_value *(size_t s)> &b, const std::function<matrix_value *(size_t s)> &x
+    ) const
+    {
+        size_t n = m_size;
+        forEachPack(m_packs, m_threads, [&](size_t pack) {
+            size_t lanes = std::min(LANES, m_count - pack * LANES);
+            vector packed(n * LANES);
+            for (size_t l = 0; l < lanes; l++) {
+                const matrix_value *values = b(pack * LANES + l);
+                for (size_t i = 0; i < n; i++) {
+                    packed[i * LANES + l] = values[i];
+                }
+            }
+
+            substitute(pack, packed.data());
+
+            for (size_t l = 0; l < lanes; l++) {
+                matrix_value *values = x(pack * LANES + l);
+                for (size_t i = 0; i < n; i++) {
+                    values[i] = packed[i * LANES + l];
+                }
+            }
+        });
+    }
+
+    std::vector<vector> BatchedLU::solve(const std::vector<vector> &b) const
+    {
+        if (b.size() != m_count) {
+            throw std::runtime_error("Impossible to solve a system with such dimensions");
+        }
+        for (auto &&v : b) {
+            if (v.size() != m_size) {
+                throw std::runtime_error("Impossible to solve a system with such dimensions");
+            }
+        }
+
+        std::vector<vector> x(m_count, vector(m_size));
+        solveAll(
+            [&b](size_t s) {
+                return b[s].data();
+            },
+            [&x](size_t s) {
+                return x[s].data();
+            }
+        );
+        return x;
+    }
+
+    vector BatchedLU::solve(const vector &b) const
+    {
+        if (b.size() != m_count * m_size) {
+            throw std::runtime_error("Impossible to solve a system with such dimensions");
+        }
+
+        vector x(b.size());
+        size_t n = m_size;
+        solveAll(
+            [&b, n](size_t s) {
+                return &b[s * n];
+            },
+            [&x, n](size_t s) {
+                return &x[s * n];
+            }
+        );
+        return x;
+    }
+
+    std::vector<vector> solveLinearSystems(const std::vector<Matrix> &matrices, const std::vector<vector> &b, size_t threads)
+    {
+        return BatchedLU(matrices, threads).solve(b);
+    }
+} // namespace math
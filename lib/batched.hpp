@@ -0,0 +1,60 @@
+#pragma once
+#include "matrix.hpp"
+#include <functional>
+#include <vector>
+
+namespace math
+{
+    // LU factorizations with partial pivoting of many independent systems of
+    // the same (small) size, done together. The batch is stored in packs of
+    // LANES systems, interleaved: element (i, j) of the systems in a pack is
+    // contiguous, so the elimination runs across them in its innermost loop,
+    // which vectorizes however small the systems are, while a pack as a whole
+    // stays in cache. The packs are split between `threads` threads (all
+    // available ones by default). It pays off for systems of up to about ten
+    // unknowns; math::LU vectorizes larger ones well enough by itself.
+    class BatchedLU
+    {
+      public:
+        static constexpr size_t LANES = 16;
+
+      private:
+        size_t m_size, m_count, m_packs, m_threads;
+        // Element (i, j) of system p * LANES + l is at
+        // ((p * m_size + j) * m_size + i) * LANES + l; the last pack is padded
+        // with identity matrices
+        vector m_lu;
+        // At step k, row k of system p * LANES + l was swapped with row
+        // m_pivots[(p * m_size + k) * LANES + l]
+        std::vector<size_t> m_pivots;
+
+        // Both take where the values of system s are: its column-major
+        // matrix, or its right-hand side and solution
+        void factorizeAll(const std::function<const matrix_value *(size_t s)> &system);
+        void solveAll(
+            const std::function<const matrix_value *(size_t s)> &b, const std::function<matrix_value *(size_t s)> &x
+        ) const;
+        void factorize(size_t pack);
+        // x is interleaved like the factors: x_i of system pack * LANES + l
+        // is at i * LANES + l
+        void substitute(size_t pack, matrix_value *x) const;
+
+      public:
+        explicit BatchedLU(const std::vector<Matrix> &matrices, size_t threads = 0);
+        // The matrices one after another, each laid out like Matrix::m_values;
+        // saves allocating a Matrix for each of many tiny systems
+        BatchedLU(size_t size, const vector &matrices, size_t threads = 0);
+
+        size_t size() const;
+        size_t count() const;
+
+        // b[s] is the right-hand side for system s
+        std::vector<vector> solve(const std::vector<vector> &b) const;
+        // The right-hand sides one after another, and so the solutions
+        vector solve(const vector &b) const;
+    };
+
+    // Factorizes on every call, like solveLinearSystem does for one system
+    std::vector<vector>
+    solveLinearSystems(const std::vector<Matrix> &matrices, const std::vector<vector> &b, size_t threads = 0);
+} // namespace math
@@ -0,0 +1,57 @@
+#include "blas.hpp"
+#include "matrix.hpp"
+#include <cmath>
+
+namespace math
+{
+    matrix_value dot(const vector &x, const vector &y)
+    {
+        matrix_value result = 0;
+        for (size_t i = 0; i < x.size(); i++) {
+            result += x[i] * y[i];
+        }
+        return result;
+    }
+
+    matrix_value nrm2(const vector &x)
+    {
+        return std::sqrt(dot(x, x));
+    }
+
+    void axpy(matrix_value k, const vector &x, vector &y)
+    {
+        for (size_t i = 0; i < y.size(); i++) {
+            y[i] += k * x[i];
+        }
+    }
+
+    void scal(matrix_value k, vector &x)
+    {
+        for (size_t i = 0; i < x.size(); i++) {
+            x[i] *= k;
+        }
+    }
+
+    void gemv(matrix_value alpha, const Matrix &A, const vector &x, matrix_value beta, vector &y)
+    {
+        if (A.m_width != x.size() || A.m_height != y.size()) {
+            throw std::runtime_error("Impossible to multiply such matrix and vector");
+        }
+
+        // So that y may come in uninitialized
+        if (beta == 0) {
+            std::fill(y.begin(), y.end(), 0);
+        } else if (beta != 1) {
+            scal(beta, y);
+        }
+
+        // A sum of the columns, so that the matrix is read in storage order
+        for (size_t j = 0; j < A.m_width; j++) {
+            const matrix_value *column = &A.m_values[j * A.m_height];
+            matrix_value k = alpha * x[j];
+            for (size_t i = 0; i < A.m_height; i++) {
+                y[i] += column[i] * k;
+            }
+        }
+    }
+} // namespace math
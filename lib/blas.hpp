@@ -0,0 +1,212 @@
+#pragma once
+#include "math.hpp"
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace math
+{
+    using matrix_value = value_t;
+    using vector = std::vector<matrix_value>;
+
+    class Matrix;
+
+    // BLAS levels 1 and 2, writing into vectors that are already there, so
+    // that iterative methods don't allocate inside their loops
+    matrix_value dot(const vector &x, const vector &y);
+    matrix_value nrm2(const vector &x);
+    // y += k x
+    void axpy(matrix_value k, const vector &x, vector &y);
+    // x *= k
+    void scal(matrix_value k, vector &x);
+    // y = alpha A x + beta y, where y is not x
+    void gemv(matrix_value alpha, const Matrix &A, const vector &x, matrix_value beta, vector &y);
+
+    // Element-wise vector arithmetic is lazy: `a * x + b * y - z` builds a
+    // tree of these, which is evaluated in a single loop once it is assigned,
+    // with no temporary vectors in between
+    namespace expressions
+    {
+        template <typename E> struct Expression {
+            // Anywhere a vector is expected
+            operator vector() const
+            {
+                const E &self = static_cast<const E &>(*this);
+                vector result(self.size());
+                for (size_t i = 0; i < result.size(); i++) {
+                    result[i] = self[i];
+                }
+                return result;
+            }
+        };
+
+        template <typename T>
+        concept expression = std::is_base_of_v<Expression<std::remove_cvref_t<T>>, std::remove_cvref_t<T>>;
+        template <typename T>
+        concept operand = expression<T> || std::is_same_v<std::remove_cvref_t<T>, vector>;
+
+        // A vector that outlives the expression
+        class Reference : public Expression<Reference>
+        {
+            const vector &m_vector;
+
+          public:
+            Reference(const vector &v) : m_vector(v)
+            {
+            }
+            size_t size() const
+            {
+                return m_vector.size();
+            }
+            matrix_value operator[](size_t i) const
+            {
+                return m_vector[i];
+            }
+        };
+
+        // A temporary one, kept inside, so that `auto r = b - A * x` is safe
+        class Temporary : public Expression<Temporary>
+        {
+            vector m_vector;
+
+          public:
+            Temporary(vector &&v) : m_vector(std::move(v))
+            {
+            }
+            size_t size() const
+            {
+                return m_vector.size();
+            }
+            matrix_value operator[](size_t i) const
+            {
+                return m_vector[i];
+            }
+        };
+
+        template <typename E, typename Operation> class Scaled : public Expression<Scaled<E, Operation>>
+        {
+            E m_operand;
+            matrix_value m_k;
+
+          public:
+            Scaled(E operand, matrix_value k) : m_operand(std::move(operand)), m_k(k)
+            {
+            }
+            size_t size() const
+            {
+                return m_operand.size();
+            }
+            matrix_value operator[](size_t i) const
+            {
+                return Operation {}(m_operand[i], m_k);
+            }
+        };
+
+        template <typename L, typename R, typename Operation> class Binary : public Expression<Binary<L, R, Operation>>
+        {
+            L m_left;
+            R m_right;
+
+          public:
+            Binary(L left, R right) : m_left(std::move(left)), m_right(std::move(right))
+            {
+                if (m_left.size() != m_right.size()) {
+                    throw std::runtime_error("Impossible to add vectors of different sizes");
+                }
+            }
+            size_t size() const
+            {
+                return m_left.size();
+            }
+            matrix_value operator[](size_t i) const
+            {
+                return Operation {}(m_left[i], m_right[i]);
+            }
+        };
+
+        inline Reference wrap(const vector &v)
+        {
+            return v;
+        }
+        inline Temporary wrap(vector &&v)
+        {
+            return std::move(v);
+        }
+        template <expression E> std::remove_cvref_t<E> wrap(E &&e)
+        {
+            return std::forward<E>(e);
+        }
+        template <typename T> using wrapped_t = decltype(wrap(std::declval<T>()));
+    } // namespace expressions
+
+    // Of an expression, without forming it
+    template <expressions::expression E> matrix_value nrm2(const E &e)
+    {
+        matrix_value result = 0;
+        for (size_t i = 0; i < e.size(); i++) {
+            result += e[i] * e[i];
+        }
+        return std::sqrt(result);
+    }
+
+    // y = e in one loop; y only allocates if it is too short
+    template <expressions::operand E> void assign(vector &y, E &&e)
+    {
+        auto operand = expressions::wrap(std::forward<E>(e));
+        y.resize(operand.size());
+        for (size_t i = 0; i < y.size(); i++) {
+            y[i] = operand[i];
+        }
+    }
+} // namespace math
+
+template <math::expressions::operand L, math::expressions::operand R> auto operator+(L &&left, R &&right)
+{
+    using namespace math::expressions;
+    return Binary<wrapped_t<L>, wrapped_t<R>, std::plus<>>(wrap(std::forward<L>(left)), wrap(std::forward<R>(right)));
+}
+
+template <math::expressions::operand L, math::expressions::operand R> auto operator-(L &&left, R &&right)
+{
+    using namespace math::expressions;
+    return Binary<wrapped_t<L>, wrapped_t<R>, std::minus<>>(wrap(std::forward<L>(left)), wrap(std::forward<R>(right)));
+}
+
+template <math::expressions::operand E> auto operator*(math::matrix_value k, E &&e)
+{
+    using namespace math::expressions;
+    return Scaled<wrapped_t<E>, std::multiplies<>>(wrap(std::forward<E>(e)), k);
+}
+
+template <math::expressions::operand E> auto operator/(E &&e, math::matrix_value k)
+{
+    using namespace math::expressions;
+    return Scaled<wrapped_t<E>, std::divides<>>(wrap(std::forward<E>(e)), k);
+}
+
+template <math::expressions::operand E> math::vector &operator+=(math::vector &v, E &&e)
+{
+    auto operand = math::expressions::wrap(std::forward<E>(e));
+    if (operand.size() != v.size()) {
+        throw std::runtime_error("Impossible to add vectors of different sizes");
+    }
+    for (size_t i = 0; i < v.size(); i++) {
+        v[i] += operand[i];
+    }
+    return v;
+}
+
+template <math::expressions::operand E> math::vector &operator-=(math::vector &v, E &&e)
+{
+    auto operand = math::expressions::wrap(std::forward<E>(e));
+    if (operand.size() != v.size()) {
+        throw std::runtime_error("Impossible to subtract vectors of different sizes");
+    }
+    for (size_t i = 0; i < v.size(); i++) {
+        v[i] -= operand[i];
+    }
+    return v;
+}
@@ -0,0 +1,482 @@
+#include "eigen.hpp"
+#include <algorithm>
+#include <barrier>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+namespace math
+{
+    // Jacobi converges quadratically once all elements have been visited a
+    // few times; this many sweeps only happen when e is out of reach
+    static constexpr size_t MAX_SWEEPS = 50;
+    // QL takes two or three iterations per eigenvalue
+    static constexpr size_t MAX_QL_ITERATIONS = 30;
+    // Sweeps that skip elements below a fraction of the average one
+    static constexpr size_t THRESHOLD_SWEEPS = 3;
+
+    struct Rotation {
+        size_t p, q;
+        matrix_value c = 1, s = 0;
+    };
+
+    // The rotation J (J(p, p) = J(q, q) = c, J(p, q) = -J(q, p) = s) for
+    // which (J^T A J)(p, q) = 0, taking the smaller of the two angles
+    static Rotation getRotation(const Matrix &A, size_t p, size_t q)
+    {
+        matrix_value apq = A(p, q);
+        if (apq == 0) {
+            return {p, q};
+        }
+
+        matrix_value theta = (A(q, q) - A(p, p)) / (2 * apq);
+        matrix_value t = sign(theta) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+        matrix_value c = 1 / std::sqrt(t * t + 1);
+        return {p, q, c, t * c};
+    }
+
+    // M = M J, only touching columns p and q, which are contiguous
+    static void rotateColumns(Matrix &M, const Rotation &r)
+    {
+        matrix_value *cp = &M.m_values[r.p * M.m_height], *cq = &M.m_values[r.q * M.m_height];
+        for (size_t i = 0; i < M.m_height; i++) {
+            matrix_value a = cp[i], b = cq[i];
+            cp[i] = r.c * a - r.s * b;
+            cq[i] = r.s * a + r.c * b;
+        }
+    }
+
+    // M = J^T M for column j of M alone
+    static void rotateRows(Matrix &M, const Rotation &r, size_t j)
+    {
+        matrix_value *column = &M.m_values[j * M.m_height];
+        matrix_value a = column[r.p], b = column[r.q];
+        column[r.p] = r.c * a - r.s * b;
+        column[r.q] = r.s * a + r.c * b;
+    }
+
+    // A = J^T A J and X = X J, in place
+    static void rotate(Matrix &A, Matrix &X, const Rotation &r)
+    {
+        rotateColumns(A, r);
+        for (size_t j = 0; j < A.m_width; j++) {
+            rotateRows(A, r, j);
+        }
+        A(r.p, r.q) = A(r.q, r.p) = 0;
+
+        rotateColumns(X, r);
+    }
+
+    static void checkSymmetric(const Matrix &A)
+    {
+        if (A.m_height != A.m_width) {
+            throw std::runtime_error("Impossible to find eigenvalues of a non-square matrix");
+        }
+    }
+
+    static std::pair<size_t, size_t> getLargestAboveDiagonal(const Matrix &A)
+    {
+        size_t ir = 0, jr = 1;
+        for (size_t j = 1; j < A.m_width; j++) {
+            const matrix_value *column = &A.m_values[j * A.m_height];
+            for (size_t i = 0; i < j; i++) {
+                if (std::abs(column[i]) > std::abs(A(ir, jr))) {
+                    ir = i;
+                    jr = j;
+                }
+            }
+        }
+        return {ir, jr};
+    }
+
+    // Largest and total absolute value above the diagonal
+    static std::pair<matrix_value, matrix_value> measureOffDiagonal(const Matrix &A)
+    {
+        matrix_value largest = 0, sum = 0;
+        for (size_t j = 1; j < A.m_width; j++) {
+            const matrix_value *column = &A.m_values[j * A.m_height];
+            for (size_t i = 0; i < j; i++) {
+                largest = std::max(largest, std::abs(column[i]));
+                sum += std::abs(column[i]);
+            }
+        }
+        return {largest, sum};
+    }
+
+    static matrix_value getThreshold(size_t sweep, matrix_value sum, size_t n)
+    {
+        return sweep < THRESHOLD_SWEEPS ? 0.2 * sum / (n * n) : 0;
+    }
+
+    static eigenpairs_t getEigenpairs(const Matrix &A, const Matrix &X)
+    {
+        eigenpairs_t result;
+        for (size_t i = 0; i < A.m_width; i++) {
+            auto column = X.m_values.begin() + i * X.m_height;
+            result.push_back({A(i, i), vector(column, column + X.m_height)});
+        }
+        return result;
+    }
+
+    eigenpairs_t getJacobiEigenvectors(Matrix A, value_t e, size_t *steps)
+    {
+        checkSymmetric(A);
+        Matrix X = Matrix::id(A.m_height);
+
+        if (steps) {
+            *steps = 0;
+        }
+        while (A.m_height > 1) {
+            auto [p, q] = getLargestAboveDiagonal(A);
+            if (std::abs(A(p, q)) < e) {
+                break;
+            }
+
+            rotate(A, X, getRotation(A, p, q));
+            if (steps) {
+                (*steps)++;
+            }
+        }
+
+        return getEigenpairs(A, X);
+    }
+
+    eigenpairs_t getCyclicJacobiEigenvectors(Matrix A, value_t e, size_t *sweeps)
+    {
+        checkSymmetric(A);
+        size_t n = A.m_height;
+        Matrix X = Matrix::id(n);
+
+        size_t sweep = 0;
+        for (;; sweep++) {
+            auto [largest, sum] = measureOffDiagonal(A);
+            if (largest < e) {
+                break;
+            }
+            if (sweep == MAX_SWEEPS) {
+                throw std::runtime_error("Jacobi method did not converge");
+            }
+
+            matrix_value threshold = getThreshold(sweep, sum, n);
+            for (size_t q = 1; q < n; q++) {
+                for (size_t p = 0; p < q; p++) {
+                    if (std::abs(A(p, q)) > threshold) {
+                        rotate(A, X, getRotation(A, p, q));
+                    }
+                }
+            }
+        }
+
+        if (sweeps) {
+            *sweeps = sweep;
+        }
+        return getEigenpairs(A, X);
+    }
+
+    eigenpairs_t getParallelJacobiEigenvectors(Matrix A, value_t e, size_t threads, size_t *sweeps)
+    {
+        checkSymmetric(A);
+        size_t n = A.m_height;
+        Matrix X = Matrix::id(n);
+
+        if (!threads) {
+            threads = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+
+        // Round-robin tournament between the indices (and a dummy one when n
+        // is odd): players[0] stays, the others move one seat each round, and
+        // players[i] meets players[m - 1 - i]. After m - 1 rounds every pair
+        // has met once, which makes a sweep.
+        size_t m = n + n % 2;
+        std::vector<size_t> players(m);
+        std::iota(players.begin(), players.end(), 0);
+        std::vector<Rotation> rotations(m / 2);
+
+        size_t sweep = 0, round = 0;
+        matrix_value threshold = 0;
+        bool converged = false, done = false;
+
+        auto startSweep = [&] {
+            auto [largest, sum] = measureOffDiagonal(A);
+            converged = largest < e;
+            done = converged || sweep == MAX_SWEEPS;
+            threshold = getThreshold(sweep, sum, n);
+        };
+        auto startRound = [&] {
+            for (size_t i = 0; i < m / 2; i++) {
+                size_t p = players[i], q = players[m - 1 - i];
+                rotations[i].p = std::min(p, q);
+                rotations[i].q = std::max(p, q);
+            }
+        };
+
+        // Every round takes three phases with the threads in step: finding
+        // the rotations, applying them to the columns (each thread taking
+        // whole pairs of columns) and then to the rows (each thread taking a
+        // share of the columns, in all of which every pair is rotated).
+        // Between rounds, one thread advances the schedule.
+        size_t phase = 0;
+        auto advance = [&]() noexcept {
+            if (++phase % 3) {
+                return;
+            }
+
+            std::rotate(players.begin() + 1, players.end() - 1, players.end());
+            if (++round == m - 1) {
+                round = 0;
+                sweep++;
+                startSweep();
+            }
+            startRound();
+        };
+        std::barrier sync(threads, advance);
+
+        auto work = [&](size_t id) {
+            size_t from = n * id / threads, to = n * (id + 1) / threads;
+            while (!done) {
+                for (size_t i = id; i < rotations.size(); i += threads) {
+                    Rotation &r = rotations[i];
+                    bool skip = r.q == n || std::abs(A(r.p, r.q)) <= threshold;
+                    r = skip ? Rotation {r.p, r.q} : getRotation(A, r.p, r.q);
+                }
+                sync.arrive_and_wait();
+
+                for (size_t i = id; i < rotations.size(); i += threads) {
+                    if (rotations[i].s != 0) {
+                        rotateColumns(A, rotations[i]);
+                        rotateColumns(X, rotations[i]);
+                    }
+                }
+                sync.arrive_and_wait();
+
+                for (size_t j = from; j < to; j++) {
+                    for (auto &&r : rotations) {
+                        if (r.s == 0) {
+                            continue;
+                        }
+                        rotateRows(A, r, j);
+                        if (j == r.p) {
+                            A(r.q, r.p) = 0;
+                        } else if (j == r.q) {
+                            A(r.p, r.q) = 0;
+                        }
+                    }
+                }
+                sync.arrive_and_wait();
+            }
+        };
+
+        startSweep();
+        startRound();
+        if (!done) {
+            std::vector<std::thread> workers;
+            for (size_t id = 1; id < threads; id++) {
+                workers.emplace_back(work, id);
+            }
+            work(0);
+            for (auto &&worker : workers) {
+                worker.join();
+            }
+        }
+
+        if (!converged) {
+            throw std::runtime_error("Jacobi method did not converge");
+        }
+        if (sweeps) {
+            *sweeps = sweep;
+        }
+        return getEigenpairs(A, X);
+    }
+
+    // Reduces A to the tridiagonal Q^T A Q, with diagonal d and e[i] = (i,
+    // i + 1) for i < n - 1. Reflection k, I - beta v v^T, zeroes column k
+    // below the subdiagonal; v is kept in its place so Q can be put together
+    // afterwards if it's wanted. Everything is done column by column.
+    static void tridiagonalize(Matrix &A, vector &d, vector &e, Matrix *Q)
+    {
+        size_t n = A.m_height;
+        d.assign(n, 0);
+        e.assign(n, 0);
+        vector betas(n), p(n), w(n);
+
+        for (size_t k = 0; k + 2 < n; k++) {
+            matrix_value *v = &A.m_values[k * n];
+            matrix_value norm = 0;
+            for (size_t i = k + 1; i < n; i++) {
+                norm += v[i] * v[i];
+            }
+            norm = std::sqrt(norm);
+            if (norm == 0) {
+                continue;
+            }
+
+            // Reflecting onto -sign(x_0) ||x|| e_0 avoids cancellation in v_0,
+            // and then beta = 2 / (v.v) simplifies to this
+            matrix_value alpha = -sign(v[k + 1]) * norm;
+            v[k + 1] -= alpha;
+            matrix_value beta = -1 / (alpha * v[k + 1]);
+            betas[k] = beta;
+            e[k] = alpha;
+
+            // The trailing block becomes A - v w^T - w v^T, where p = beta A v
+            // and w = p - beta (p.v) / 2 v
+            matrix_value pv = 0;
+            for (size_t j = k + 1; j < n; j++) {
+                p[j] = 0;
+            }
+            for (size_t j = k + 1; j < n; j++) {
+                const matrix_value *column = &A.m_values[j * n];
+                for (size_t i = k + 1; i < n; i++) {
+                    p[i] += column[i] * v[j];
+                }
+            }
+            for (size_t i = k + 1; i < n; i++) {
+                p[i] *= beta;
+                pv += p[i] * v[i];
+            }
+            for (size_t i = k + 1; i < n; i++) {
+                w[i] = p[i] - beta * pv / 2 * v[i];
+            }
+            for (size_t j = k + 1; j < n; j++) {
+                matrix_value *column = &A.m_values[j * n];
+                for (size_t i = k + 1; i < n; i++) {
+                    column[i] -= v[i] * w[j] + w[i] * v[j];
+                }
+            }
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            d[i] = A(i, i);
+        }
+        if (n > 1) {
+            e[n - 2] = A(n - 1, n - 2);
+        }
+
+        if (!Q) {
+            return;
+        }
+
+        // Q = H_0 ... H_{n-3}, applying the reflections from the last one, so
+        // that each only touches the trailing block it acts on
+        *Q = Matrix::id(n);
+        for (size_t k = n < 2 ? 0 : n - 2; k-- > 0;) {
+            const matrix_value *v = &A.m_values[k * n];
+            for (size_t j = k + 1; j < n; j++) {
+                matrix_value *column = &Q->m_values[j * n];
+                matrix_value s = 0;
+                for (size_t i = k + 1; i < n; i++) {
+                    s += v[i] * column[i];
+                }
+                s *= betas[k];
+                for (size_t i = k + 1; i < n; i++) {
+                    column[i] -= s * v[i];
+                }
+            }
+        }
+    }
+
+    // Implicit QL with Wilkinson shifts on the tridiagonal (d, e), leaving the
+    // eigenvalues in d. The rotations are also applied to the columns of Z,
+    // if it's given, so that Z = Q turns into the eigenvectors of Q T Q^T.
+    static void diagonalizeTridiagonal(vector &d, vector &e, Matrix *Z)
+    {
+        size_t n = d.size();
+        for (size_t l = 0; l < n; l++) {
+            for (size_t iteration = 0;; iteration++) {
+                // The block l..m splits off at the first negligible e[m]
+                size_t m = l;
+                while (m + 1 < n &&
+                       std::abs(e[m]) > std::numeric_limits<matrix_value>::epsilon() * (std::abs(d[m]) + std::abs(d[m + 1]))) {
+                    m++;
+                }
+                if (m == l) {
+                    break;
+                }
+                if (iteration == MAX_QL_ITERATIONS) {
+                    throw std::runtime_error("QL method did not converge");
+                }
+
+                // The shift is the eigenvalue of the leading 2 x 2 block closer
+                // to d[l]; the bulge it makes is chased up from the bottom
+                matrix_value g = (d[l + 1] - d[l]) / (2 * e[l]);
+                matrix_value r = std::hypot(g, matrix_value(1));
+                g = d[m] - d[l] + e[l] / (g + (g < 0 ? -r : r));
+
+                matrix_value s = 1, c = 1, p = 0;
+                bool split = false;
+                for (size_t i = m; i-- > l;) {
+                    matrix_value f = s * e[i], b = c * e[i];
+                    r = std::hypot(f, g);
+                    e[i + 1] = r;
+                    if (r == 0) {
+                        // Underflow: the matrix has split at i + 1 already
+                        d[i + 1] -= p;
+                        e[m] = 0;
+                        split = true;
+                        break;
+                    }
+
+                    s = f / r;
+                    c = g / r;
+                    g = d[i + 1] - p;
+                    r = (d[i] - g) * s + 2 * c * b;
+                    p = s * r;
+                    d[i + 1] = g + p;
+                    g = c * r - b;
+
+                    if (Z) {
+                        matrix_value *zi = &Z->m_values[i * n], *zj = zi + n;
+                        for (size_t k = 0; k < n; k++) {
+                            matrix_value t = zj[k];
+                            zj[k] = s * zi[k] + c * t;
+                            zi[k] = c * zi[k] - s * t;
+                        }
+                    }
+                }
+                if (split) {
+                    continue;
+                }
+
+                d[l] -= p;
+                e[l] = g;
+                e[m] = 0;
+            }
+        }
+    }
+
+    eigenpairs_t getSymmetricEigenvectors(Matrix A)
+    {
+        checkSymmetric(A);
+        size_t n = A.m_height;
+
+        vector d, e;
+        Matrix Z(n, n);
+        tridiagonalize(A, d, e, &Z);
+        diagonalizeTridiagonal(d, e, &Z);
+
+        std::vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&d](size_t i, size_t j) { return d[i] < d[j]; });
+
+        eigenpairs_t result;
+        for (size_t i : order) {
+            auto column = Z.m_values.begin() + i * n;
+            result.push_back({d[i], vector(column, column + n)});
+        }
+        return result;
+    }
+
+    vector getSymmetricEigenvalues(Matrix A)
+    {
+        checkSymmetric(A);
+
+        vector d, e;
+        tridiagonalize(A, d, e, nullptr);
+        diagonalizeTridiagonal(d, e, nullptr);
+
+        std::sort(d.begin(), d.end());
+        return d;
+    }
+} // namespace math
@@ -0,0 +1,37 @@
+#pragma once
+#include "matrix.hpp"
+#include <utility>
+#include <vector>
+
+namespace math
+{
+    // Eigenvalues of a symmetric matrix, each with its (unit) eigenvector,
+    // in the order of the diagonal they end up on
+    using eigenpairs_t = std::vector<std::pair<matrix_value, vector>>;
+
+    // Jacobi rotations until every off-diagonal element is below e. The
+    // classical method rotates away the largest element each time; finding
+    // it is an O(n^2) scan per rotation, so it only suits small matrices.
+    // `steps` receives the number of rotations.
+    eigenpairs_t getJacobiEigenvectors(Matrix A, value_t e, size_t *steps = nullptr);
+
+    // Cyclic Jacobi: sweeps over all the off-diagonal elements in order,
+    // without searching. The first sweeps skip elements that are small
+    // compared to the rest, which saves rotations while the matrix is still
+    // far from diagonal. `sweeps` receives the number of sweeps.
+    eigenpairs_t getCyclicJacobiEigenvectors(Matrix A, value_t e, size_t *sweeps = nullptr);
+
+    // Cyclic Jacobi where each sweep is split into rounds of n/2 rotations
+    // on disjoint pairs of indices (Brent-Luk round-robin ordering). Those
+    // commute, so every round is applied by `threads` threads at once (all
+    // available ones by default).
+    eigenpairs_t getParallelJacobiEigenvectors(Matrix A, value_t e, size_t threads = 0, size_t *sweeps = nullptr);
+
+    // Householder reduction to tridiagonal form, then implicit QL with
+    // Wilkinson shifts on the tridiagonal matrix: O(n^3) with a small
+    // constant and no tolerance to choose. Eigenvalues come out ascending.
+    eigenpairs_t getSymmetricEigenvectors(Matrix A);
+    // The same without accumulating the eigenvectors, which is most of the
+    // work: the QL iterations drop from O(n^3) to O(n^2)
+    vector getSymmetricEigenvalues(Matrix A);
+} // namespace math
@@ -0,0 +1,380 @@
+#include "krylov.hpp"
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+namespace math
+{
+    linear_operator_t getOperator(const Matrix &A)
+    {
+        return [&A](const vector &x, vector &y) {
+            std::fill(y.begin(), y.end(), 0);
+            for (size_t j = 0; j < A.m_width; j++) {
+                const matrix_value *column = &A.m_values[j * A.m_height];
+                for (size_t i = 0; i < A.m_height; i++) {
+                    y[i] += column[i] * x[j];
+                }
+            }
+        };
+    }
+
+    linear_operator_t getOperator(const SparseMatrix &A)
+    {
+        return [&A](const vector &x, vector &y) { A.multiply(x, y); };
+    }
+
+    static vector getDiagonal(const SparseMatrix &A)
+    {
+        if (A.m_height != A.m_width) {
+            throw std::runtime_error("Impossible to precondition a non-square matrix");
+        }
+
+        vector diagonal(A.m_height);
+        for (size_t i = 0; i < A.m_height; i++) {
+            diagonal[i] = A(i, i);
+            if (diagonal[i] == 0) {
+                throw std::runtime_error("Matrix has a zero on the diagonal");
+            }
+        }
+        return diagonal;
+    }
+
+    preconditioner_t getJacobiPreconditioner(const SparseMatrix &A)
+    {
+        vector inverse = getDiagonal(A);
+        for (auto &&value : inverse) {
+            value = 1 / value;
+        }
+
+        return [inverse = std::move(inverse)](const vector &r, vector &z) {
+            for (size_t i = 0; i < r.size(); i++) {
+                z[i] = r[i] * inverse[i];
+            }
+        };
+    }
+
+    preconditioner_t getSSORPreconditioner(const SparseMatrix &A, value_t omega)
+    {
+        auto matrix = std::make_shared<const SparseMatrix>(A);
+        auto diagonal = std::make_shared<const vector>(getDiagonal(A));
+
+        return [matrix, diagonal, omega](const vector &r, vector &z) {
+            const SparseMatrix &A = *matrix;
+            const vector &d = *diagonal;
+
+            // (D + wL) y = r, then (D + wU) z = D y, both in z
+            for (size_t i = 0; i < A.m_height; i++) {
+                matrix_value sum = r[i];
+                for (size_t k = A.m_rowStarts[i]; k < A.m_rowStarts[i + 1] && A.m_columns[k] < i; k++) {
+                    sum -= omega * A.m_values[k] * z[A.m_columns[k]];
+                }
+                z[i] = sum / d[i];
+            }
+            for (size_t i = A.m_height; i-- > 0;) {
+                matrix_value sum = d[i] * z[i];
+                for (size_t k = A.m_rowStarts[i + 1]; k-- > A.m_rowStarts[i] && A.m_columns[k] > i;) {
+                    sum -= omega * A.m_values[k] * z[A.m_columns[k]];
+                }
+                z[i] = sum / d[i];
+            }
+            for (auto &&value : z) {
+                value *= omega * (2 - omega);
+            }
+        };
+    }
+
+    preconditioner_t getILU0Preconditioner(const SparseMatrix &A)
+    {
+        if (A.m_height != A.m_width) {
+            throw std::runtime_error("Impossible to precondition a non-square matrix");
+        }
+
+        // Gaussian elimination row by row (the IKJ order), dropping every
+        // update that falls outside the pattern of A. L (with a unit
+        // diagonal) and U are left packed in a copy of A.
+        auto LU = std::make_shared<SparseMatrix>(A);
+        size_t n = LU->m_height;
+        const auto &starts = LU->m_rowStarts;
+        const auto &columns = LU->m_columns;
+        auto &values = LU->m_values;
+
+        std::vector<size_t> diagonal(n), position(n, -1);
+        for (size_t i = 0; i < n; i++) {
+            diagonal[i] = LU->find(i, i);
+            if (diagonal[i] == size_t(-1)) {
+                throw std::runtime_error("Matrix has a zero on the diagonal");
+            }
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            for (size_t k = starts[i]; k < starts[i + 1]; k++) {
+                position[columns[k]] = k;
+            }
+
+            for (size_t k = starts[i]; k < starts[i + 1] && columns[k] < i; k++) {
+                size_t row = columns[k];
+                if (values[diagonal[row]] == 0) {
+                    throw std::runtime_error("Matrix is degenerate");
+                }
+
+                values[k] /= values[diagonal[row]];
+                for (size_t l = diagonal[row] + 1; l < starts[row + 1]; l++) {
+                    if (position[columns[l]] != size_t(-1)) {
+                        values[position[columns[l]]] -= values[k] * values[l];
+                    }
+                }
+            }
+
+            for (size_t k = starts[i]; k < starts[i + 1]; k++) {
+                position[columns[k]] = -1;
+            }
+        }
+
+        return [LU = std::shared_ptr<const SparseMatrix>(LU), diagonal](const vector &r, vector &z) {
+            const auto &starts = LU->m_rowStarts;
+            const auto &columns = LU->m_columns;
+            const auto &values = LU->m_values;
+
+            for (size_t i = 0; i < r.size(); i++) {
+                matrix_value sum = r[i];
+                for (size_t k = starts[i]; k < diagonal[i]; k++) {
+                    sum -= values[k] * z[columns[k]];
+                }
+                z[i] = sum;
+            }
+            for (size_t i = r.size(); i-- > 0;) {
+                matrix_value sum = z[i];
+                for (size_t k = diagonal[i] + 1; k < starts[i + 1]; k++) {
+                    sum -= values[k] * z[columns[k]];
+                }
+                z[i] = sum / values[diagonal[i]];
+            }
+        };
+    }
+
+    static void precondition(const SolverOptions &options, const vector &r, vector &z)
+    {
+        if (options.preconditioner) {
+            options.preconditioner(r, z);
+        } else {
+            z = r;
+        }
+    }
+
+    // Whether to go on
+    static bool report(const SolverOptions &options, size_t iteration, value_t residual)
+    {
+        return residual > options.tolerance && (!options.callback || options.callback(iteration, residual));
+    }
+
+    // r = b - Ax, returning ||b||, or 0 (with x = 0 solving the system) if b = 0
+    static matrix_value start(const linear_operator_t &A, const vector &b, vector &x, vector &r)
+    {
+        if (x.size() != b.size()) {
+            throw std::runtime_error("Impossible to solve a system with such dimensions");
+        }
+
+        matrix_value bNorm = nrm2(b);
+        if (bNorm == 0) {
+            std::fill(x.begin(), x.end(), 0);
+            std::fill(r.begin(), r.end(), 0);
+            return 0;
+        }
+
+        A(x, r);
+        for (size_t i = 0; i < r.size(); i++) {
+            r[i] = b[i] - r[i];
+        }
+        return bNorm;
+    }
+
+    namespace solveLinearSystemUsing
+    {
+        SolverResult conjugateGradients(const linear_operator_t &A, const vector &b, vector &x, const SolverOptions &options)
+        {
+            size_t n = b.size();
+            vector r(n), z(n), p(n), q(n);
+
+            matrix_value bNorm = start(A, b, x, r);
+            if (bNorm == 0) {
+                return {0, 0, true};
+            }
+
+            matrix_value residual = nrm2(r) / bNorm;
+            size_t iteration = 0;
+            if (residual > options.tolerance) {
+                precondition(options, r, z);
+                p = z;
+                matrix_value rz = dot(r, z);
+
+                while (iteration < options.maxIterations) {
+                    A(p, q);
+                    matrix_value alpha = rz / dot(p, q);
+                    axpy(alpha, p, x);
+                    axpy(-alpha, q, r);
+
+                    residual = nrm2(r) / bNorm;
+                    if (!report(options, ++iteration, residual)) {
+                        break;
+                    }
+
+                    precondition(options, r, z);
+                    matrix_value rzNext = dot(r, z);
+                    matrix_value beta = rzNext / rz;
+                    rz = rzNext;
+                    for (size_t i = 0; i < n; i++) {
+                        p[i] = z[i] + beta * p[i];
+                    }
+                }
+            }
+
+            return {iteration, residual, residual <= options.tolerance};
+        }
+
+        SolverResult biCGStab(const linear_operator_t &A, const vector &b, vector &x, const SolverOptions &options)
+        {
+            size_t n = b.size();
+            vector r(n), p(n), v(n), t(n), pp(n), sp(n);
+
+            matrix_value bNorm = start(A, b, x, r);
+            if (bNorm == 0) {
+                return {0, 0, true};
+            }
+
+            const vector r0 = r;
+            matrix_value rho = 1, alpha = 1, omega = 1;
+            matrix_value residual = nrm2(r) / bNorm;
+            size_t iteration = 0;
+
+            while (residual > options.tolerance && iteration < options.maxIterations) {
+                matrix_value rhoNext = dot(r0, r);
+                if (rhoNext == 0) {
+                    // Breakdown: r has become orthogonal to r0
+                    break;
+                }
+
+                matrix_value beta = rhoNext / rho * alpha / omega;
+                rho = rhoNext;
+                for (size_t i = 0; i < n; i++) {
+                    p[i] = r[i] + beta * (p[i] - omega * v[i]);
+                }
+
+                precondition(options, p, pp);
+                A(pp, v);
+                alpha = rho / dot(r0, v);
+                // r is now s = r - alpha v
+                axpy(-alpha, v, r);
+                axpy(alpha, pp, x);
+
+                residual = nrm2(r) / bNorm;
+                if (residual <= options.tolerance) {
+                    report(options, ++iteration, residual);
+                    break;
+                }
+
+                precondition(options, r, sp);
+                A(sp, t);
+                matrix_value tt = dot(t, t);
+                omega = tt == 0 ? 0 : dot(t, r) / tt;
+                axpy(omega, sp, x);
+                axpy(-omega, t, r);
+
+                residual = nrm2(r) / bNorm;
+                if (!report(options, ++iteration, residual) || omega == 0) {
+                    break;
+                }
+            }
+
+            return {iteration, residual, residual <= options.tolerance};
+        }
+
+        SolverResult gmres(const linear_operator_t &A, const vector &b, vector &x, const SolverOptions &options)
+        {
+            size_t n = b.size(), m = std::max<size_t>(options.restart, 1);
+            vector r(n), w(n), z(n);
+
+            matrix_value bNorm = start(A, b, x, r);
+            if (bNorm == 0) {
+                return {0, 0, true};
+            }
+
+            // Arnoldi basis V, and the Hessenberg matrix H by columns, turned
+            // upper triangular as it's built by the Givens rotations (c, s)
+            std::vector<vector> V(m + 1, vector(n)), H(m, vector(m + 1));
+            vector c(m), s(m), g(m + 1), y(m);
+
+            matrix_value residual = nrm2(r) / bNorm;
+            size_t iteration = 0;
+            bool stop = residual <= options.tolerance;
+
+            while (!stop && iteration < options.maxIterations) {
+                matrix_value beta = nrm2(r);
+                for (size_t i = 0; i < n; i++) {
+                    V[0][i] = r[i] / beta;
+                }
+                std::fill(g.begin(), g.end(), 0);
+                g[0] = beta;
+
+                size_t j = 0;
+                while (j < m && iteration < options.maxIterations && !stop) {
+                    precondition(options, V[j], z);
+                    A(z, w);
+
+                    // Modified Gram-Schmidt
+                    for (size_t i = 0; i <= j; i++) {
+                        H[j][i] = dot(w, V[i]);
+                        axpy(-H[j][i], V[i], w);
+                    }
+                    H[j][j + 1] = nrm2(w);
+                    bool exhausted = H[j][j + 1] == 0;
+                    if (!exhausted) {
+                        for (size_t i = 0; i < n; i++) {
+                            V[j + 1][i] = w[i] / H[j][j + 1];
+                        }
+                    }
+
+                    for (size_t i = 0; i < j; i++) {
+                        matrix_value h = c[i] * H[j][i] + s[i] * H[j][i + 1];
+                        H[j][i + 1] = -s[i] * H[j][i] + c[i] * H[j][i + 1];
+                        H[j][i] = h;
+                    }
+                    matrix_value h = std::hypot(H[j][j], H[j][j + 1]);
+                    c[j] = h == 0 ? 1 : H[j][j] / h;
+                    s[j] = h == 0 ? 0 : H[j][j + 1] / h;
+                    H[j][j] = h;
+                    H[j][j + 1] = 0;
+                    g[j + 1] = -s[j] * g[j];
+                    g[j] *= c[j];
+
+                    j++;
+                    residual = std::abs(g[j]) / bNorm;
+                    // When the basis can't be extended, the solution is in it
+                    stop = !report(options, ++iteration, residual) || exhausted;
+                }
+
+                // x += M^-1 V y, where H y = g
+                for (size_t i = j; i-- > 0;) {
+                    y[i] = g[i];
+                    for (size_t k = i + 1; k < j; k++) {
+                        y[i] -= H[k][i] * y[k];
+                    }
+                    y[i] = H[i][i] == 0 ? 0 : y[i] / H[i][i];
+                }
+                std::fill(w.begin(), w.end(), 0);
+                for (size_t i = 0; i < j; i++) {
+                    axpy(y[i], V[i], w);
+                }
+                precondition(options, w, z);
+                x += z;
+
+                if (!stop) {
+                    start(A, b, x, r);
+                    residual = nrm2(r) / bNorm;
+                    stop = residual <= options.tolerance;
+                }
+            }
+
+            return {iteration, residual, residual <= options.tolerance};
+        }
+    } // namespace solveLinearSystemUsing
+} // namespace math
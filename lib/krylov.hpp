@@ -0,0 +1,55 @@
+#pragma once
+#include "matrix.hpp"
+#include "sparse.hpp"
+#include <functional>
+
+namespace math
+{
+    // y = A x for some A that is never formed; y comes in with the right size
+    using linear_operator_t = std::function<void(const vector &x, vector &y)>;
+    // z = M^-1 r for some M close to A that is cheap to invert
+    using preconditioner_t = std::function<void(const vector &r, vector &z)>;
+    // Called after every iteration with the relative residual ||b - Ax|| /
+    // ||b||; returning false stops the solver
+    using convergence_callback_t = std::function<bool(size_t iteration, value_t residual)>;
+
+    // These keep a reference to the matrix, which has to outlive them
+    linear_operator_t getOperator(const Matrix &A);
+    linear_operator_t getOperator(const SparseMatrix &A);
+
+    // M = D
+    preconditioner_t getJacobiPreconditioner(const SparseMatrix &A);
+    // M = (D + wL) D^-1 (D + wU) / (w (2 - w)); symmetric when A is
+    preconditioner_t getSSORPreconditioner(const SparseMatrix &A, value_t omega = 1);
+    // M = LU, with L and U only where A has non-zeros (incomplete LU without
+    // fill-in)
+    preconditioner_t getILU0Preconditioner(const SparseMatrix &A);
+
+    struct SolverOptions {
+        // On the relative residual
+        value_t tolerance = 1e-10;
+        size_t maxIterations = 1000;
+        // None by default
+        preconditioner_t preconditioner;
+        convergence_callback_t callback;
+        // Krylov subspace size between GMRES restarts
+        size_t restart = 30;
+    };
+
+    struct SolverResult {
+        size_t iterations;
+        value_t residual;
+        bool converged;
+    };
+
+    // Each solves Ax = b starting from the x given
+    namespace solveLinearSystemUsing
+    {
+        // A must be symmetric positive definite, and so must the preconditioner
+        SolverResult conjugateGradients(const linear_operator_t &A, const vector &b, vector &x, const SolverOptions &options = {});
+        SolverResult biCGStab(const linear_operator_t &A, const vector &b, vector &x, const SolverOptions &options = {});
+        // Restarted GMRES(m), preconditioned on the right so that the residual
+        // it minimizes is the real one
+        SolverResult gmres(const linear_operator_t &A, const vector &b, vector &x, const SolverOptions &options = {});
+    } // namespace solveLinearSystemUsing
+} // namespace math
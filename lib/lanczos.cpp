@@ -0,0 +1,519 @@
+#include "lanczos.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+namespace math
+{
+    using complex_t = std::complex<value_t>;
+
+    static constexpr size_t MIN_SUBSPACE = 20;
+    // Per eigenvalue of the Hessenberg matrix and per row of it, as in LAPACK:
+    // QR converges only linearly to a defective eigenvalue
+    static constexpr size_t MAX_QR_ITERATIONS = 30;
+    static constexpr matrix_value EPSILON = std::numeric_limits<matrix_value>::epsilon();
+
+    static size_t getSubspaceSize(size_t size, size_t k, const KrylovEigenOptions &options)
+    {
+        if (k == 0 || k > size) {
+            throw std::runtime_error("Impossible to find that many eigenvalues");
+        }
+
+        size_t m = std::min(options.subspace ? options.subspace : std::max(2 * k + 1, MIN_SUBSPACE), size);
+        if (m <= k && m < size) {
+            throw std::runtime_error("Krylov subspace is too small for that many eigenvalues");
+        }
+        return m;
+    }
+
+    static void normalize(vector &v)
+    {
+        scal(1 / nrm2(v), v);
+    }
+
+    // Random, so that it has a component along every eigenvector, but the
+    // same every time
+    static vector getStartingVector(size_t size)
+    {
+        std::mt19937 generator(1);
+        std::uniform_real_distribution<double> distribution(-1, 1);
+
+        vector v(size);
+        for (auto &&value : v) {
+            value = distribution(generator);
+        }
+        normalize(v);
+        return v;
+    }
+
+    // Orthogonalizes w against the first `count` vectors of V, putting the
+    // coefficients into h. Gram-Schmidt twice over keeps V orthogonal to
+    // working precision, which plain Lanczos loses as eigenvalues converge.
+    static void orthogonalize(const std::vector<vector> &V, size_t count, vector &w, vector &h)
+    {
+        std::fill(h.begin(), h.begin() + count, 0);
+        for (int pass = 0; pass < 2; pass++) {
+            for (size_t i = 0; i < count; i++) {
+                matrix_value c = dot(w, V[i]);
+                h[i] += c;
+                axpy(-c, V[i], w);
+            }
+        }
+    }
+
+    // Extends the Krylov basis V (with V[from] already set) up to V.size() -
+    // 1 vectors, keeping the projections in H (H(i, j) = V[i].A V[j]), and
+    // returns the size reached and the norm of the last residual, which is
+    // 0 if the basis ended up spanning an invariant subspace
+    static std::pair<size_t, matrix_value>
+    extendBasis(const linear_operator_t &A, std::vector<vector> &V, Matrix &H, size_t from, bool symmetric)
+    {
+        size_t m = V.size() - 1;
+        vector w(V[0].size()), h(m);
+
+        for (size_t j = from; j < m; j++) {
+            A(V[j], w);
+            orthogonalize(V, j + 1, w, h);
+
+            matrix_value scale = 0;
+            for (size_t i = 0; i <= j; i++) {
+                H(i, j) = h[i];
+                if (symmetric) {
+                    H(j, i) = h[i];
+                }
+                scale = std::max(scale, std::abs(h[i]));
+            }
+
+            matrix_value beta = nrm2(w);
+            if (beta <= EPSILON * scale) {
+                return {j + 1, 0};
+            }
+            if (!symmetric) {
+                H(j + 1, j) = beta;
+            }
+            for (size_t i = 0; i < w.size(); i++) {
+                V[j + 1][i] = w[i] / beta;
+            }
+            if (j + 1 == m) {
+                return {m, beta};
+            }
+        }
+        return {m, 0};
+    }
+
+    static Matrix getLeadingBlock(const Matrix &H, size_t size)
+    {
+        Matrix result(size, size);
+        for (size_t j = 0; j < size; j++) {
+            std::copy_n(H.m_values.begin() + j * H.m_height, size, result.m_values.begin() + j * size);
+        }
+        return result;
+    }
+
+    static bool isConverged(value_t residual, value_t value, value_t scale, const KrylovEigenOptions &options)
+    {
+        return residual <= options.tolerance * std::max(std::abs(value), EPSILON * scale);
+    }
+
+    eigenpairs_t getLanczosEigenvectors(const linear_operator_t &A, size_t size, size_t k, const KrylovEigenOptions &options)
+    {
+        size_t m = getSubspaceSize(size, k, options);
+        std::vector<vector> V(m + 1, vector(size));
+        V[0] = getStartingVector(size);
+        Matrix T(m, m);
+
+        size_t kept = 0;
+        for (size_t restart = 0;; restart++) {
+            auto [used, beta] = extendBasis(A, V, T, kept, true);
+
+            eigenpairs_t ritz = getSymmetricEigenvectors(getLeadingBlock(T, used));
+            if (options.end == SpectrumEnd::Largest) {
+                std::reverse(ritz.begin(), ritz.end());
+            }
+
+            // The residual of a Ritz pair (l, Vs) is beta |s_last|
+            size_t found = std::min(k, used);
+            value_t scale = std::max(std::abs(ritz.front().first), std::abs(ritz.back().first));
+            bool converged = true;
+            for (size_t i = 0; i < found; i++) {
+                converged &= isConverged(std::abs(beta * ritz[i].second[used - 1]), ritz[i].first, scale, options);
+            }
+
+            if (converged) {
+                eigenpairs_t result;
+                for (size_t i = 0; i < found; i++) {
+                    vector x(size);
+                    for (size_t j = 0; j < used; j++) {
+                        axpy(ritz[i].second[j], V[j], x);
+                    }
+                    result.push_back({ritz[i].first, std::move(x)});
+                }
+                return result;
+            }
+            if (restart == options.maxRestarts) {
+                throw std::runtime_error("Lanczos method did not converge");
+            }
+
+            // Thick restart: the best Ritz vectors and the residual become
+            // the new basis, in which T is diagonal but for the last row and
+            // column
+            kept = std::min(k + (used - k) / 2, used - 1);
+            std::vector<vector> best(kept, vector(size));
+            for (size_t i = 0; i < kept; i++) {
+                for (size_t j = 0; j < used; j++) {
+                    axpy(ritz[i].second[j], V[j], best[i]);
+                }
+            }
+            std::swap(V[kept], V[used]);
+            for (size_t i = 0; i < kept; i++) {
+                V[i] = std::move(best[i]);
+            }
+
+            T = Matrix(m, m);
+            for (size_t i = 0; i < kept; i++) {
+                T(i, i) = ritz[i].first;
+                T(i, kept) = T(kept, i) = beta * ritz[i].second[used - 1];
+            }
+        }
+    }
+
+    std::pair<value_t, value_t> getSpectralBounds(const linear_operator_t &A, size_t size, value_t tolerance)
+    {
+        KrylovEigenOptions options;
+        options.tolerance = tolerance;
+
+        options.end = SpectrumEnd::Smallest;
+        value_t smallest = getLanczosEigenvectors(A, size, 1, options).front().first;
+        options.end = SpectrumEnd::Largest;
+        value_t largest = getLanczosEigenvectors(A, size, 1, options).front().first;
+        return {smallest, largest};
+    }
+
+    // Reduces A to the upper Hessenberg Q^T A Q. Reflection k, I - beta v v^T,
+    // zeroes column k below the subdiagonal, as in the tridiagonal reduction.
+    static void reduceToHessenberg(Matrix &A)
+    {
+        size_t n = A.m_height;
+        vector v(n), w(n);
+
+        for (size_t k = 0; k + 2 < n; k++) {
+            matrix_value norm = 0;
+            for (size_t i = k + 1; i < n; i++) {
+                v[i] = A(i, k);
+                norm += v[i] * v[i];
+            }
+            norm = std::sqrt(norm);
+            if (norm == 0) {
+                continue;
+            }
+
+            matrix_value alpha = -sign(v[k + 1]) * norm;
+            v[k + 1] -= alpha;
+            matrix_value beta = -1 / (alpha * v[k + 1]);
+
+            // From the left on the rows below k, then from the right on the
+            // columns after it
+            for (size_t j = k; j < n; j++) {
+                matrix_value *column = &A.m_values[j * n];
+                matrix_value s = 0;
+                for (size_t i = k + 1; i < n; i++) {
+                    s += v[i] * column[i];
+                }
+                s *= beta;
+                for (size_t i = k + 1; i < n; i++) {
+                    column[i] -= s * v[i];
+                }
+            }
+            std::fill(w.begin(), w.end(), 0);
+            for (size_t j = k + 1; j < n; j++) {
+                const matrix_value *column = &A.m_values[j * n];
+                for (size_t i = 0; i < n; i++) {
+                    w[i] += column[i] * v[j];
+                }
+            }
+            for (size_t j = k + 1; j < n; j++) {
+                matrix_value *column = &A.m_values[j * n];
+                for (size_t i = 0; i < n; i++) {
+                    column[i] -= beta * w[i] * v[j];
+                }
+            }
+            for (size_t i = k + 2; i < n; i++) {
+                A(i, k) = 0;
+            }
+        }
+    }
+
+    // Eigenvalues of a small dense matrix: reduced to Hessenberg form, then
+    // shifted QR. In complex arithmetic a single Wilkinson shift finds
+    // complex eigenvalues just as well, which saves the double-shift bulge
+    // chasing of real QR.
+    static std::vector<complex_t> getEigenvalues(Matrix H)
+    {
+        reduceToHessenberg(H);
+        size_t n = H.m_height;
+        std::vector<complex_t> a(H.m_values.begin(), H.m_values.end());
+        auto at = [&a, n](size_t i, size_t j) -> complex_t & { return a[j * n + i]; };
+
+        // A subdiagonal entry is negligible next to its diagonal neighbours,
+        // or, where those vanish too (as for nilpotent matrices, whose
+        // eigenvalues QR can only find to about EPSILON^(1/n)), next to H
+        value_t norm = 0;
+        for (auto &&value : H.m_values) {
+            norm = std::max(norm, std::abs(value));
+        }
+        auto isNegligible = [&](size_t i) {
+            value_t subdiagonal = std::abs(at(i, i - 1));
+            return subdiagonal <= EPSILON * (std::abs(at(i, i)) + std::abs(at(i - 1, i - 1))) ||
+                   subdiagonal <= EPSILON * norm;
+        };
+
+        std::vector<complex_t> values(n);
+        std::vector<std::pair<value_t, complex_t>> rotations(n);
+        size_t iterations = 0;
+        for (size_t hi = n; hi > 0;) {
+            size_t lo = hi - 1;
+            while (lo > 0 && !isNegligible(lo)) {
+                lo--;
+            }
+            if (lo > 0) {
+                at(lo, lo - 1) = 0;
+            }
+            if (lo == hi - 1) {
+                values[hi - 1] = at(hi - 1, hi - 1);
+                hi--;
+                iterations = 0;
+                continue;
+            }
+            if (++iterations > MAX_QR_ITERATIONS * std::max<size_t>(n, 10)) {
+                throw std::runtime_error("QR method did not converge");
+            }
+
+            // The eigenvalue of the trailing 2 x 2 block closer to its corner,
+            // nudged now and then in case the iteration is going in circles
+            complex_t a11 = at(hi - 2, hi - 2), a12 = at(hi - 2, hi - 1);
+            complex_t a21 = at(hi - 1, hi - 2), a22 = at(hi - 1, hi - 1);
+            complex_t half = (a11 + a22) / value_t(2);
+            complex_t root = std::sqrt(half * half - (a11 * a22 - a12 * a21));
+            complex_t shift = std::abs(half + root - a22) < std::abs(half - root - a22) ? half + root : half - root;
+            if (iterations % 10 == 0) {
+                shift += std::abs(a21);
+            }
+
+            // H - shift = QR by rotations from the left, then RQ + shift
+            for (size_t i = lo; i < hi; i++) {
+                at(i, i) -= shift;
+            }
+            for (size_t i = lo; i + 1 < hi; i++) {
+                complex_t x = at(i, i), y = at(i + 1, i);
+                value_t r = std::hypot(std::abs(x), std::abs(y));
+                value_t c = r == 0 ? 1 : std::abs(x) / r;
+                complex_t s = r == 0 ? 0 : (x == value_t(0) ? complex_t(1) : x / std::abs(x)) * std::conj(y) / r;
+                rotations[i] = {c, s};
+
+                for (size_t j = i; j < hi; j++) {
+                    complex_t u = at(i, j), v = at(i + 1, j);
+                    at(i, j) = c * u + s * v;
+                    at(i + 1, j) = -std::conj(s) * u + c * v;
+                }
+            }
+            for (size_t i = lo; i + 1 < hi; i++) {
+                auto [c, s] = rotations[i];
+                for (size_t r = lo; r <= i + 1; r++) {
+                    complex_t u = at(r, i), v = at(r, i + 1);
+                    at(r, i) = c * u + std::conj(s) * v;
+                    at(r, i + 1) = -s * u + c * v;
+                }
+            }
+            for (size_t i = lo; i < hi; i++) {
+                at(i, i) += shift;
+            }
+        }
+        return values;
+    }
+
+    // The unit eigenvector of H for the eigenvalue l, by two steps of
+    // inverse iteration
+    static std::vector<complex_t> getEigenvector(const Matrix &H, complex_t l)
+    {
+        size_t n = H.m_height;
+        std::vector<complex_t> y(n, 1);
+
+        for (int step = 0; step < 2; step++) {
+            std::vector<complex_t> a(H.m_values.begin(), H.m_values.end());
+            auto at = [&a, n](size_t i, size_t j) -> complex_t & { return a[j * n + i]; };
+            for (size_t i = 0; i < n; i++) {
+                at(i, i) -= l;
+            }
+
+            // Gaussian elimination with partial pivoting; l is an eigenvalue,
+            // so a pivot may come out zero, which just means y is found
+            for (size_t j = 0; j < n; j++) {
+                size_t pivot = j;
+                for (size_t i = j + 1; i < n; i++) {
+                    if (std::abs(at(i, j)) > std::abs(at(pivot, j))) {
+                        pivot = i;
+                    }
+                }
+                for (size_t c = j; c < n; c++) {
+                    std::swap(at(j, c), at(pivot, c));
+                }
+                std::swap(y[j], y[pivot]);
+                if (at(j, j) == value_t(0)) {
+                    at(j, j) = EPSILON * std::max(std::abs(l), value_t(1));
+                }
+
+                for (size_t i = j + 1; i < n; i++) {
+                    complex_t f = at(i, j) / at(j, j);
+                    for (size_t c = j + 1; c < n; c++) {
+                        at(i, c) -= f * at(j, c);
+                    }
+                    y[i] -= f * y[j];
+                }
+            }
+            for (size_t i = n; i-- > 0;) {
+                for (size_t c = i + 1; c < n; c++) {
+                    y[i] -= at(i, c) * y[c];
+                }
+                y[i] /= at(i, i);
+            }
+
+            value_t norm = 0;
+            for (auto &&value : y) {
+                norm += std::norm(value);
+            }
+            norm = std::sqrt(norm);
+            for (auto &&value : y) {
+                value /= norm;
+            }
+        }
+        return y;
+    }
+
+    // An orthonormal real basis of at most `size` columns for the span of the
+    // eigenvectors of H for the first of `values`. A complex eigenvector
+    // gives its real and imaginary parts, which span its conjugate's too, so
+    // the span is invariant under H; parts already in it (the imaginary part
+    // of a real eigenvector is only rounding) are dropped.
+    static Matrix getRitzBasis(const Matrix &H, const std::vector<complex_t> &values, size_t size)
+    {
+        size_t n = H.m_height;
+        std::vector<vector> basis;
+        for (size_t i = 0; i < values.size() && basis.size() < size; i++) {
+            std::vector<complex_t> y = getEigenvector(H, values[i]);
+
+            // With its largest component real, most of y is in its real part
+            complex_t phase = *std::max_element(y.begin(), y.end(), [](complex_t a, complex_t b) {
+                return std::abs(a) < std::abs(b);
+            });
+            phase = std::conj(phase) / std::abs(phase);
+
+            std::vector<vector> parts(2, vector(n));
+            for (size_t j = 0; j < n; j++) {
+                parts[0][j] = (y[j] * phase).real();
+                parts[1][j] = (y[j] * phase).imag();
+            }
+
+            size_t added = basis.size();
+            for (auto &&part : parts) {
+                for (int pass = 0; pass < 2; pass++) {
+                    for (auto &&b : basis) {
+                        axpy(-dot(part, b), b, part);
+                    }
+                }
+                matrix_value norm = nrm2(part);
+                if (norm > std::sqrt(EPSILON)) {
+                    scal(1 / norm, part);
+                    basis.push_back(std::move(part));
+                }
+            }
+            // Half of a conjugate pair wouldn't be invariant
+            if (basis.size() > size) {
+                basis.resize(added);
+                break;
+            }
+        }
+
+        Matrix S(n, basis.size());
+        for (size_t j = 0; j < basis.size(); j++) {
+            std::copy(basis[j].begin(), basis[j].end(), S.m_values.begin() + j * n);
+        }
+        return S;
+    }
+
+    std::vector<complex_t> getArnoldiEigenvalues(const linear_operator_t &A, size_t size, size_t k, const KrylovEigenOptions &options)
+    {
+        size_t m = getSubspaceSize(size, k, options);
+        std::vector<vector> V(m + 1, vector(size));
+        V[0] = getStartingVector(size);
+        Matrix H(m + 1, m);
+
+        size_t kept = 0;
+        for (size_t restart = 0;; restart++) {
+            auto [used, beta] = extendBasis(A, V, H, kept, false);
+            Matrix block = getLeadingBlock(H, used);
+
+            std::vector<complex_t> values = getEigenvalues(block);
+            std::sort(values.begin(), values.end(), [&options](complex_t a, complex_t b) {
+                return options.end == SpectrumEnd::Largest ? std::abs(a) > std::abs(b) : std::abs(a) < std::abs(b);
+            });
+
+            // The residual of a Ritz pair (l, Vy) is beta |y_last|, as for
+            // Lanczos
+            size_t found = std::min(k, used);
+            value_t scale = std::max(std::abs(values.front()), std::abs(values.back()));
+            bool converged = true;
+            for (size_t i = 0; i < found && converged; i++) {
+                value_t residual = beta == 0 ? 0 : beta * std::abs(getEigenvector(block, values[i]).back());
+                converged = isConverged(residual, std::abs(values[i]), scale, options);
+            }
+
+            if (converged) {
+                values.resize(found);
+                return values;
+            }
+            if (restart == options.maxRestarts) {
+                throw std::runtime_error("Arnoldi method did not converge");
+            }
+
+            // Krylov-Schur restart: with S a basis of the wanted Ritz vectors of
+            // the block, so that block S = S T, A VS = VS T + beta v (e_last S),
+            // so VS and the residual v are a basis to extend just like a Krylov
+            // one, with T and beta e_last S as the first columns of H. Keeping
+            // more Ritz vectors than wanted keeps the next ones converging too.
+            Matrix S = getRitzBasis(block, values, std::min(k + (used - k) / 2, used - 1));
+            kept = S.m_width;
+
+            std::vector<vector> best(kept, vector(size));
+            for (size_t i = 0; i < kept; i++) {
+                for (size_t j = 0; j < used; j++) {
+                    axpy(S(j, i), V[j], best[i]);
+                }
+            }
+            std::swap(V[kept], V[used]);
+            for (size_t i = 0; i < kept; i++) {
+                V[i] = std::move(best[i]);
+            }
+
+            // T = S^T block S
+            Matrix BS(used, kept);
+            for (size_t j = 0; j < kept; j++) {
+                for (size_t l = 0; l < used; l++) {
+                    for (size_t i = 0; i < used; i++) {
+                        BS(i, j) += block(i, l) * S(l, j);
+                    }
+                }
+            }
+            H = Matrix(m + 1, m);
+            for (size_t j = 0; j < kept; j++) {
+                for (size_t i = 0; i < kept; i++) {
+                    for (size_t l = 0; l < used; l++) {
+                        H(i, j) += S(l, i) * BS(l, j);
+                    }
+                }
+                H(kept, j) = beta * S(used - 1, j);
+            }
+        }
+    }
+} // namespace math
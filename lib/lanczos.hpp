@@ -0,0 +1,41 @@
+#pragma once
+#include "eigen.hpp"
+#include "krylov.hpp"
+#include <complex>
+#include <utility>
+#include <vector>
+
+namespace math
+{
+    // Which end of the spectrum to look at: by value for symmetric operators,
+    // by modulus for general ones
+    enum class SpectrumEnd { Largest, Smallest };
+
+    struct KrylovEigenOptions {
+        SpectrumEnd end = SpectrumEnd::Largest;
+        // On the residual ||Ax - lx|| of every eigenpair relative to |l|
+        value_t tolerance = 1e-10;
+        // Vectors in the Krylov basis, each of the operator's size; 0 picks
+        // max(2k + 1, 20)
+        size_t subspace = 0;
+        size_t maxRestarts = 300;
+    };
+
+    // The k eigenpairs at one end of the spectrum of a symmetric operator of
+    // the given size, most extreme first. Lanczos with full
+    // reorthogonalization, restarted by keeping the best Ritz vectors (thick
+    // restart), so memory stays at `subspace` vectors.
+    eigenpairs_t getLanczosEigenvectors(
+        const linear_operator_t &A, size_t size, size_t k, const KrylovEigenOptions &options = {}
+    );
+
+    // Smallest and largest eigenvalue of a symmetric operator
+    std::pair<value_t, value_t> getSpectralBounds(const linear_operator_t &A, size_t size, value_t tolerance = 1e-6);
+
+    // The k eigenvalues at one end of the spectrum of a general operator,
+    // most extreme first. Arnoldi, restarted by keeping a real basis of the
+    // best Ritz vectors (Krylov-Schur), so memory stays at `subspace` vectors.
+    std::vector<std::complex<value_t>> getArnoldiEigenvalues(
+        const linear_operator_t &A, size_t size, size_t k, const KrylovEigenOptions &options = {}
+    );
+} // namespace math
@@ -0,0 +1,177 @@
+#include "lu.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace math
+{
+    // Columns factorized together before the rest of the matrix is updated.
+    // The update then streams every remaining column past the same panel of
+    // L, which stays in cache, instead of making a pass per column of L.
+    static constexpr size_t BLOCK_SIZE = 64;
+
+    LU::LU(Matrix matrix) : m_lu(std::move(matrix))
+    {
+        if (m_lu.m_height != m_lu.m_width) {
+            throw std::runtime_error("Impossible to LU decompose matrix with such dimensions");
+        }
+
+        size_t n = m_lu.m_height;
+        matrix_value *a = m_lu.m_values.data();
+        m_pivots.resize(n);
+
+        for (size_t from = 0; from < n; from += BLOCK_SIZE) {
+            size_t to = std::min(from + BLOCK_SIZE, n);
+            factorizePanel(from, to);
+
+            // Rows from..to of the remaining columns become U (a triangular
+            // solve with the panel's L), and the rows below get the rank-k
+            // update A22 -= L21 * U12; both are the same column sweep
+            for (size_t c = to; c < n; c++) {
+                matrix_value *column = a + c * n;
+                for (size_t j = from; j < to; j++) {
+                    matrix_value u = column[j];
+                    if (u == 0) {
+                        continue;
+                    }
+
+                    const matrix_value *l = a + j * n;
+                    for (size_t i = j + 1; i < n; i++) {
+                        column[i] -= l[i] * u;
+                    }
+                }
+            }
+        }
+    }
+
+    // Unblocked elimination of columns from..to, touching only those columns
+    // (apart from the row swaps)
+    void LU::factorizePanel(size_t from, size_t to)
+    {
+        size_t n = m_lu.m_height;
+        matrix_value *a = m_lu.m_values.data();
+
+        for (size_t j = from; j < to; j++) {
+            matrix_value *column = a + j * n;
+
+            size_t pivot = j;
+            for (size_t i = j + 1; i < n; i++) {
+                if (std::abs(column[i]) > std::abs(column[pivot])) {
+                    pivot = i;
+                }
+            }
+            if (column[pivot] == 0) {
+                throw std::runtime_error("Matrix is degenerate");
+            }
+
+            m_pivots[j] = pivot;
+            if (pivot != j) {
+                m_lu.swapRows(pivot, j);
+                m_sign = -m_sign;
+            }
+
+            matrix_value inverse = 1 / column[j];
+            for (size_t i = j + 1; i < n; i++) {
+                column[i] *= inverse;
+            }
+
+            for (size_t c = j + 1; c < to; c++) {
+                matrix_value *other = a + c * n;
+                matrix_value u = other[j];
+                for (size_t i = j + 1; i < n; i++) {
+                    other[i] -= column[i] * u;
+                }
+            }
+        }
+    }
+
+    void LU::permute(matrix_value *b) const
+    {
+        for (size_t k = 0; k < m_pivots.size(); k++) {
+            if (m_pivots[k] != k) {
+                std::swap(b[k], b[m_pivots[k]]);
+            }
+        }
+    }
+
+    // Forward substitution with L, then backward with U; both walk the
+    // packed matrix column by column
+    void LU::substitute(matrix_value *b) const
+    {
+        size_t n = m_lu.m_height;
+        const matrix_value *a = m_lu.m_values.data();
+
+        for (size_t j = 0; j < n; j++) {
+            matrix_value x = b[j];
+            if (x == 0) {
+                continue;
+            }
+
+            const matrix_value *l = a + j * n;
+            for (size_t i = j + 1; i < n; i++) {
+                b[i] -= l[i] * x;
+            }
+        }
+
+        for (size_t j = n; j-- > 0;) {
+            const matrix_value *u = a + j * n;
+            b[j] /= u[j];
+
+            matrix_value x = b[j];
+            for (size_t i = 0; i < j; i++) {
+                b[i] -= u[i] * x;
+            }
+        }
+    }
+
+    size_t LU::size() const
+    {
+        return m_lu.m_height;
+    }
+
+    const Matrix &LU::packed() const
+    {
+        return m_lu;
+    }
+
+    vector LU::solve(const vector &b) const
+    {
+        if (b.size() != size()) {
+            throw std::runtime_error("Impossible to solve a system with such dimensions");
+        }
+
+        vector x = b;
+        permute(x.data());
+        substitute(x.data());
+        return x;
+    }
+
+    Matrix LU::solve(const Matrix &B) const
+    {
+        if (B.m_height != size()) {
+            throw std::runtime_error("Impossible to solve a system with such dimensions");
+        }
+
+        Matrix X = B;
+        for (size_t c = 0; c < X.m_width; c++) {
+            matrix_value *column = X.m_values.data() + c * X.m_height;
+            permute(column);
+            substitute(column);
+        }
+        return X;
+    }
+
+    matrix_value LU::determinant() const
+    {
+        matrix_value result = m_sign;
+        for (size_t i = 0; i < size(); i++) {
+            result *= m_lu(i, i);
+        }
+        return result;
+    }
+
+    Matrix LU::inverse() const
+    {
+        return solve(Matrix::id(size()));
+    }
+} // namespace math
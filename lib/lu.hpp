@@ -0,0 +1,39 @@
+#pragma once
+#include "matrix.hpp"
+#include <vector>
+
+namespace math
+{
+    // LU factorization with partial pivoting, PA = LU. Both factors are kept
+    // packed in one matrix: U on and above the diagonal, L (whose diagonal is
+    // all ones) below it. Factorizing costs O(n^3) once; after that every
+    // solve is O(n^2), so an operator used for many right-hand sides should
+    // be factorized once and kept.
+    class LU
+    {
+      private:
+        Matrix m_lu;
+        // At step k, row k was swapped with row m_pivots[k]
+        std::vector<size_t> m_pivots;
+        int m_sign = 1;
+
+        void factorizePanel(size_t from, size_t to);
+
+        void permute(matrix_value *b) const;
+        void substitute(matrix_value *b) const;
+
+      public:
+        // Takes the matrix by value, so a matrix that is no longer needed can
+        // be moved in and factorized in place
+        explicit LU(Matrix matrix);
+
+        size_t size() const;
+        const Matrix &packed() const;
+
+        vector solve(const vector &b) const;
+        // Solves for every column of B at once
+        Matrix solve(const Matrix &B) const;
+        matrix_value determinant() const;
+        Matrix inverse() const;
+    };
+} // namespace math
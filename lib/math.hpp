@@ -1,9 +1,16 @@
 #pragma once
 #include <functional>
 
+// Scalar type of the whole numerical core, chosen at build time, e.g.
+// `make ... DEFINES=-DMATH_VALUE_T=double`. long double is the most
+// accurate, but x87 arithmetic can't be vectorized; double and float can.
+#ifndef MATH_VALUE_T
+#define MATH_VALUE_T long double
+#endif
+
 namespace math
 {
-    using value_t = long double;
+    using value_t = MATH_VALUE_T;
     using simple_function_t = std::function<value_t(value_t)>;
     using two_arg_function_t = std::function<value_t(value_t, value_t)>;
 
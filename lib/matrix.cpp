@@ -1,6 +1,9 @@
 #include "matrix.hpp"
+#include "lanczos.hpp"
+#include "lu.hpp"
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 std::ostream &operator<<(std::ostream &stream, const math::vector &v)
 {
@@ -15,143 +18,40 @@ std::ostream &operator<<(std::ostream &stream, const math::vector &v)
     return stream;
 }
 
-math::vector operator*(math::matrix_value k, math::vector v)
-{
-    for (size_t i = 0; i < v.size(); i++) {
-        v[i] *= k;
-    }
-    return v;
-}
-
 math::Matrix operator*(math::matrix_value k, math::Matrix m)
 {
-    for (size_t i = 0; i < m.m_height; i++) {
-        for (size_t j = 0; j < m.m_width; j++) {
-            m(i, j) *= k;
-        }
-    }
-    return m;
-}
-
-math::vector operator/(math::vector v, math::matrix_value k)
-{
-    for (size_t i = 0; i < v.size(); i++) {
-        v[i] /= k;
-    }
-    return v;
+    return m *= k;
 }
 
 math::vector operator*(const math::Matrix &m, const math::vector &v)
 {
-    if (m.m_width != v.size()) {
-        throw std::runtime_error("Impossible to multiply such matrix and vector");
-    }
-
     math::vector result(m.m_height);
-
-    for (size_t i = 0; i < m.m_height; i++) {
-        for (size_t j = 0; j < m.m_width; j++) {
-            result[i] += m(i, j) * v[j];
-        }
-    }
-
+    math::gemv(1, m, v, 0, result);
     return result;
 }
 
 math::matrix_value operator*(const math::vector &v1, const math::vector &v2)
 {
-    math::matrix_value result = 0;
-    for (size_t i = 0; i < v2.size(); i++) {
-        result += v1[i] * v2[i];
-    }
-    return result;
+    return math::dot(v1, v2);
 }
 
-math::vector operator+(const math::vector &v1, const math::vector &v2)
+math::vector &operator*=(math::vector &v, math::matrix_value k)
 {
-    math::vector result = v1;
-    for (size_t i = 0; i < result.size(); i++) {
-        result[i] += v2[i];
-    }
-    return result;
-}
-
-math::vector operator-(const math::vector &v1, const math::vector &v2)
-{
-    math::vector result = v1;
-    for (size_t i = 0; i < result.size(); i++) {
-        result[i] -= v2[i];
-    }
-    return result;
+    math::scal(k, v);
+    return v;
 }
 
 math::matrix_value euclideanNorm(const math::vector &v)
 {
-    return std::sqrt(v * v);
+    return math::nrm2(v);
 }
 
 namespace math
 {
 
-    static constexpr matrix_value EPSILON = 1e-12;
-
-    class Matrix::Row
-    {
-
-      private:
-        size_t m_row;
-        Matrix &m_matrix;
-        matrix_value m_coef = 1;
-
-      private:
-        Row(Matrix &m, size_t row);
-        Row(Matrix &m, size_t row, matrix_value coef);
-
-        Row operator-() const;
-        Row operator*(matrix_value k) const;
-        Row operator/(matrix_value k) const;
-        Row &operator+=(const Row &row);
-        Row &operator-=(const Row &row);
-        Row &operator*=(matrix_value k);
-        Row &operator/=(matrix_value k);
-        matrix_value operator()(size_t j) const;
-
-        friend Matrix;
-        friend inline Row operator*(matrix_value k, const Row &&row)
-        {
-            return row * k;
-        }
-    };
-
-    class Matrix::Column
-    {
-
-      private:
-        size_t m_column;
-        Matrix &m_matrix;
-
-        matrix_value m_coef = 1;
-
-      private:
-        Column(Matrix &m, size_t column);
-        Column(Matrix &m, size_t column, matrix_value coef);
-
-        Column operator-() const;
-        Column operator*(matrix_value k) const;
-        Column operator/(matrix_value k) const;
-        Column &operator+=(const Column &column);
-        Column &operator-=(const Column &column);
-        matrix_value operator()(size_t i) const;
-        size_t mainElementIndex() const;
-        size_t mainElementIndex(size_t from) const;
-        size_t mainElementIndex(size_t from, size_t to) const;
-
-        friend Matrix;
-        friend inline Column operator*(matrix_value k, const Column &column)
-        {
-            return column * k;
-        }
-    };
+    // Pivots below this count as zero; a few thousand ulps around 1, which is
+    // 1e-12 for double and scales with whatever matrix_value is built as
+    static constexpr matrix_value EPSILON = 4096 * std::numeric_limits<matrix_value>::epsilon();
 
     Matrix::Matrix(size_t height, size_t width) : m_width(width), m_height(height), m_values(width * height)
     {
@@ -243,43 +143,76 @@ namespace math
         return stream;
     }
 
-    void Matrix::gaussForwards(bool chooseMainElement)
+    // Zeroes column `pivot` in rows from..to by subtracting multiples of row
+    // `pivot`. Storage is column-major, so rather than walking rows with a
+    // stride of m_height, the multipliers are taken once from the pivot
+    // column and every later column gets a contiguous update.
+    static void eliminate(Matrix &m, size_t pivot, size_t from, size_t to)
     {
-        for (size_t j = 0; j < m_height; j++) {
+        size_t h = m.m_height;
+        matrix_value *a = m.m_values.data();
+        matrix_value *l = a + pivot * h;
+
+        // The multipliers are stored in place of the elements they eliminate
+        // only while the later columns are updated, then cleared below
+        matrix_value inverse = 1 / l[pivot];
+        for (size_t i = from; i < to; i++) {
+            l[i] *= inverse;
+        }
+
+        for (size_t c = pivot + 1; c < m.m_width; c++) {
+            matrix_value *column = a + c * h;
+            matrix_value u = column[pivot];
+            if (u == 0) {
+                continue;
+            }
+            for (size_t i = from; i < to; i++) {
+                column[i] -= l[i] * u;
+            }
+        }
+
+        // Leaves the column zeroed, as the elimination itself would
+        std::fill(l + from, l + to, 0);
+    }
+
+    int Matrix::gaussForwards(bool chooseMainElement)
+    {
+        int sign = 1;
+        for (size_t j = 0, n = std::min(m_height, m_width); j < n; j++) {
+            const matrix_value *column = &m_values[j * m_height];
             if (chooseMainElement) {
-                size_t mainElementIndex = column(j).mainElementIndex(j);
+                size_t mainElementIndex = j;
+                for (size_t i = j + 1; i < m_height; i++) {
+                    if (std::abs(column[i]) > std::abs(column[mainElementIndex])) {
+                        mainElementIndex = i;
+                    }
+                }
                 if (mainElementIndex != j) {
                     swapRows(mainElementIndex, j);
+                    sign = -sign;
                 }
             }
 
-            for (size_t i = j + 1; i < m_height; i++) {
-                if (eq((*this)(i, j), 0)) {
-                    if (chooseMainElement) {
-                        break;
-                    } else {
-                        throw std::runtime_error("Matrix is degenerate");
-                    }
+            if (eq(column[j], 0)) {
+                if (chooseMainElement) {
+                    // Nothing left to eliminate in this column
+                    continue;
                 }
-
-                row(i) -= row(j) / (*this)(j, j) * (*this)(i, j);
+                throw std::runtime_error("Matrix is degenerate");
             }
+
+            eliminate(*this, j, j + 1, m_height);
         }
+        return sign;
     }
 
     void Matrix::gaussBackwards()
     {
-        for (int j = m_height - 1; j >= 0; j--) {
-            // size_t mainElementIndex = column(j).mainElementIndex(0, j + 1);
-            // if (mainElementIndex != j) {swapRows(mainElementIndex, j);}
-
-            for (int i = j - 1; i >= 0; i--) {
-                if (eq((*this)(i, j), 0)) {
-                    continue;
-                }
-
-                row(i) -= row(j) / (*this)(j, j) * (*this)(i, j);
+        for (size_t j = std::min(m_height, m_width); j-- > 0;) {
+            if (eq((*this)(j, j), 0)) {
+                continue;
             }
+            eliminate(*this, j, 0, j);
         }
     }
 
@@ -318,9 +251,9 @@ namespace math
             }
         }
 
-        temp.gaussForwards(false);
+        temp.gaussForwards();
         for (size_t i = 0; i < m_height; i++) {
-            if (temp(i, i) == 0) {
+            if (eq(temp(i, i), 0)) {
                 throw std::runtime_error("Matrix is degenerate");
             }
         }
@@ -332,11 +265,33 @@ namespace math
 
     void Matrix::normalize()
     {
-        for (size_t i = 0; i < m_height; i++) {
+        vector scale(m_height, 1);
+        for (size_t i = 0, n = std::min(m_height, m_width); i < n; i++) {
             if (!eq((*this)(i, i), 0)) {
-                row(i) /= (*this)(i, i);
+                scale[i] = 1 / (*this)(i, i);
             }
         }
+
+        for (size_t j = 0; j < m_width; j++) {
+            matrix_value *column = &m_values[j * m_height];
+            for (size_t i = 0; i < m_height; i++) {
+                column[i] *= scale[i];
+            }
+        }
+    }
+
+    matrix_value Matrix::determinant() const
+    {
+        if (m_width != m_height) {
+            throw std::runtime_error("Non-square matrix doesn't have a determinant");
+        }
+
+        Matrix temp = *this;
+        matrix_value result = temp.gaussForwards();
+        for (size_t i = 0; i < m_height; i++) {
+            result *= temp(i, i);
+        }
+        return result;
     }
 
     std::pair<Matrix, Matrix> Matrix::decomposeLU() const
@@ -354,14 +309,14 @@ namespace math
             for (size_t j = i; j < m_height; j++) {
                 lu.first(j, i) = (*this)(j, i);
 
-                for (size_t k = 0; k <= i - 1; k++) {
+                for (size_t k = 0; k < i; k++) {
                     lu.first(j, i) -= lu.first(j, k) * lu.second(k, i);
                 }
             }
             for (size_t j = i + 1; j < m_height; j++) {
                 lu.second(i, j) = (*this)(i, j);
 
-                for (size_t k = 0; k <= i - 1; k++) {
+                for (size_t k = 0; k < i; k++) {
                     lu.second(i, j) -= lu.first(i, k) * lu.second(k, j);
                 }
                 lu.second(i, j) /= lu.first(i, i);
@@ -371,6 +326,49 @@ namespace math
         return lu;
     }
 
+    // The product is accumulated a column of A at a time (C(:, j) += A(:, k)
+    // * B(k, j)), so the innermost loop runs down contiguous columns of A
+    // and C. Blocking keeps a ROW_BLOCK x INNER_BLOCK tile of A in cache
+    // while it is applied to every column of C, and taking four columns of
+    // A per pass saves loads and stores of C.
+    static constexpr size_t ROW_BLOCK = 64;
+    static constexpr size_t INNER_BLOCK = 64;
+
+    static void multiplyAdd(const Matrix &A, const Matrix &B, Matrix &C)
+    {
+        size_t m = A.m_height, n = B.m_width, l = A.m_width;
+        const matrix_value *a = A.m_values.data(), *b = B.m_values.data();
+        matrix_value *c = C.m_values.data();
+
+        for (size_t kFrom = 0; kFrom < l; kFrom += INNER_BLOCK) {
+            size_t kTo = std::min(kFrom + INNER_BLOCK, l);
+            for (size_t iFrom = 0; iFrom < m; iFrom += ROW_BLOCK) {
+                size_t iTo = std::min(iFrom + ROW_BLOCK, m);
+
+                for (size_t j = 0; j < n; j++) {
+                    matrix_value *cj = c + j * m;
+                    const matrix_value *bj = b + j * l;
+
+                    size_t k = kFrom;
+                    for (; k + 4 <= kTo; k += 4) {
+                        const matrix_value *a0 = a + k * m, *a1 = a0 + m, *a2 = a1 + m, *a3 = a2 + m;
+                        matrix_value b0 = bj[k], b1 = bj[k + 1], b2 = bj[k + 2], b3 = bj[k + 3];
+                        for (size_t i = iFrom; i < iTo; i++) {
+                            cj[i] += a0[i] * b0 + a1[i] * b1 + a2[i] * b2 + a3[i] * b3;
+                        }
+                    }
+                    for (; k < kTo; k++) {
+                        const matrix_value *ak = a + k * m;
+                        matrix_value bk = bj[k];
+                        for (size_t i = iFrom; i < iTo; i++) {
+                            cj[i] += ak[i] * bk;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
     Matrix Matrix::operator*(const Matrix &m) const
     {
         if (m_width != m.m_height) {
@@ -378,48 +376,77 @@ namespace math
         }
 
         Matrix result(m_height, m.m_width);
-
-        for (size_t i = 0; i < m_height; i++) {
-            for (size_t j = 0; j < m.m_width; j++) {
-                for (size_t k = 0; k < m_width; k++) {
-                    result(i, j) += (*this)(i, k) * m(k, j);
-                }
-            }
-        }
-
+        multiplyAdd(*this, m, result);
         return result;
     }
 
     Matrix Matrix::operator+(const Matrix &m) const
+    {
+        Matrix result = *this;
+        return result += m;
+    }
+
+    Matrix Matrix::operator-(const Matrix &m) const
+    {
+        Matrix result = *this;
+        return result -= m;
+    }
+
+    Matrix &Matrix::operator+=(const Matrix &m)
     {
         if (m_width != m.m_width || m_height != m.m_height) {
             throw std::runtime_error("Impossible to add such matrices");
         }
 
-        Matrix result(m_height, m_width);
-        for (size_t i = 0; i < m_height; i++) {
-            for (size_t j = 0; j < m_width; j++) {
-                result(i, j) = (*this)(i, j) + m(i, j);
-            }
+        for (size_t i = 0; i < m_values.size(); i++) {
+            m_values[i] += m.m_values[i];
         }
-
-        return result;
+        return *this;
     }
 
-    Matrix Matrix::operator-(const Matrix &m) const
+    Matrix &Matrix::operator-=(const Matrix &m)
     {
         if (m_width != m.m_width || m_height != m.m_height) {
             throw std::runtime_error("Impossible to subtract such matrices");
         }
 
-        Matrix result(m_height, m_width);
-        for (size_t i = 0; i < m_height; i++) {
-            for (size_t j = 0; j < m_width; j++) {
-                result(i, j) = (*this)(i, j) - m(i, j);
-            }
+        for (size_t i = 0; i < m_values.size(); i++) {
+            m_values[i] -= m.m_values[i];
         }
+        return *this;
+    }
 
-        return result;
+    Matrix &Matrix::operator*=(matrix_value k)
+    {
+        for (auto &&value : m_values) {
+            value *= k;
+        }
+        return *this;
+    }
+
+    Matrix &Matrix::addScaled(matrix_value k, const Matrix &m)
+    {
+        if (m_width != m.m_width || m_height != m.m_height) {
+            throw std::runtime_error("Impossible to add such matrices");
+        }
+
+        for (size_t i = 0; i < m_values.size(); i++) {
+            m_values[i] += k * m.m_values[i];
+        }
+        return *this;
+    }
+
+    Matrix &Matrix::addProduct(const Matrix &a, const Matrix &b)
+    {
+        if (a.m_width != b.m_height || a.m_height != m_height || b.m_width != m_width) {
+            throw std::runtime_error("Impossible to multiply such matrices");
+        }
+
+        if (&a == this || &b == this) {
+            return *this += a * b;
+        }
+        multiplyAdd(a, b, *this);
+        return *this;
     }
 
     matrix_value Matrix::norm() const
@@ -439,31 +466,39 @@ namespace math
         return result;
     }
 
-    static math::matrix_value scalarProduct(const math::vector &v1, const math::vector &v2)
+    static constexpr size_t POWER_ITERATIONS = 50;
+
+    // The power method, for when Arnoldi doesn't converge: only an estimate,
+    // but always one. The geometric mean of the last two growth factors also
+    // settles for a complex pair of dominant eigenvalues.
+    static matrix_value estimateSpectralRadius(const Matrix &A)
     {
-        math::matrix_value result = 0;
-        for (size_t i = 0; i < v1.size(); i++) {
-            result += v1[i] * v2[i];
+        linear_operator_t apply = getOperator(A);
+        vector x(A.m_height, 1), y(A.m_height);
+        matrix_value previous = 0, growth = nrm2(x);
+        for (size_t k = 0; k < POWER_ITERATIONS; k++) {
+            scal(1 / growth, x);
+            apply(x, y);
+            std::swap(x, y);
+            previous = growth;
+            growth = nrm2(x);
+            if (growth == 0) {
+                return 0;
+            }
         }
-        return result;
+        return std::sqrt(previous * growth);
     }
 
     matrix_value Matrix::spectralRadius() const
     {
-        Matrix xCurrent(m_height, 1);
-        Matrix xNext(m_height, 1);
-        for (size_t i = 0; i < m_height; i++) {
-            xCurrent(i, 0) = 1;
+        if (m_height != m_width) {
+            throw std::runtime_error("Impossible to find spectral radius of a non-square matrix");
         }
-
-        matrix_value lambda = 0;
-        for (size_t k = 0; k < 50; k++) {
-            xNext = (*this) * xCurrent;
-            lambda = scalarProduct(xNext.m_values, xCurrent.m_values) / scalarProduct(xCurrent.m_values, xCurrent.m_values);
-            xCurrent = xNext;
+        try {
+            return std::abs(getArnoldiEigenvalues(getOperator(*this), m_height, 1).front());
+        } catch (const std::runtime_error &e) {
+            return estimateSpectralRadius(*this);
         }
-
-        return std::abs(lambda);
     }
 
     Matrix Matrix::id(size_t size)
@@ -505,330 +540,83 @@ namespace math
             throw std::runtime_error("Impossible to solve a system with such dimensions");
         }
 
-        const std::pair<Matrix, Matrix> lu = matrix.decomposeLU();
-        const Matrix &L = lu.first;
-        const Matrix &U = lu.second;
-
-        std::cout << L << std::endl;
-        std::cout << U << std::endl;
-
-        for (size_t i = 0; i < L.m_height; i++) {
-            if (L(i, i) == 0) {
-                throw std::runtime_error("Matrix is degenerate");
-            }
-        }
-
-        // std::cout << "1" << std::endl;
-        vector lResult = solveLowerTriangularLinearSystem(L, v);
-        vector uResult = solveUpperTriangularLinearSystem(U, lResult);
-        // std::cout << "2" << std::endl;
-        return uResult;
-    }
-
-    vector solveLowerTriangularLinearSystem(const Matrix &matrix, const vector &vc)
-    {
-        if (vc.size() != matrix.m_height) {
-            throw std::runtime_error("Impossible to solve a system with such dimensions");
-        }
-
-        vector v;
-        v.insert(v.end(), matrix.m_values.begin(), matrix.m_values.end());
-        v.insert(v.end(), vc.begin(), vc.end());
-        Matrix temp(matrix.m_height, matrix.m_height + 1, v);
-        std::cout << "a" << std::endl;
-        auto b = solveLowerTriangularLinearSystem(temp);
-        std::cout << "b" << std::endl;
-        return b;
+        return LU(matrix).solve(v);
     }
 
-    vector solveLowerTriangularLinearSystem(const Matrix &extendedMatrix)
+    // Substitution with the leading n x n block of `matrix`, overwriting `x`.
+    // Each solved unknown is subtracted from the rest a column at a time.
+    static void substituteLower(const Matrix &matrix, vector &x)
     {
-        if (extendedMatrix.m_width != extendedMatrix.m_height + 1) {
-            throw std::runtime_error("Impossible to solve a system with such dimensions");
-        }
-        for (size_t i = 0; i < extendedMatrix.m_height; i++) {
-            if (extendedMatrix(i, i) == 0) {
+        size_t n = x.size();
+        for (size_t j = 0; j < n; j++) {
+            const matrix_value *column = &matrix.m_values[j * matrix.m_height];
+            if (column[j] == 0) {
                 throw std::runtime_error("Matrix is degenerate");
             }
-        }
 
-        Matrix temp = extendedMatrix;
-
-        vector result(temp.m_height);
-        for (size_t i = 0; i <= temp.m_height; i++) {
-            matrix_value x = temp(i, temp.m_width - 1);
-            for (size_t j = 0; j < i; j++) {
-                x -= temp(i, j) * result[j];
+            x[j] /= column[j];
+            for (size_t i = j + 1; i < n; i++) {
+                x[i] -= column[i] * x[j];
             }
-            result[i] = x / temp(i, i);
         }
-
-        return result;
     }
 
-    vector solveUpperTriangularLinearSystem(const Matrix &extendedMatrix)
+    static void substituteUpper(const Matrix &matrix, vector &x)
     {
-        if (extendedMatrix.m_width != extendedMatrix.m_height + 1) {
-            throw std::runtime_error("Impossible to solve a system with such dimensions");
-        }
-        for (size_t i = 0; i < extendedMatrix.m_height; i++) {
-            if (extendedMatrix(i, i) == 0) {
+        for (size_t j = x.size(); j-- > 0;) {
+            const matrix_value *column = &matrix.m_values[j * matrix.m_height];
+            if (column[j] == 0) {
                 throw std::runtime_error("Matrix is degenerate");
             }
-        }
 
-        Matrix temp = extendedMatrix;
-
-        vector result(temp.m_height);
-        for (int i = temp.m_height - 1; i >= 0; i--) {
-            matrix_value x = temp(i, temp.m_width - 1);
-            for (int j = temp.m_height - 1; j > i; j--) {
-                x -= temp(i, j) * result[j];
+            x[j] /= column[j];
+            for (size_t i = 0; i < j; i++) {
+                x[i] -= column[i] * x[j];
             }
-            result[i] = x / temp(i, i);
-            if (i == 0) break;
         }
-
-        return result;
     }
 
-    vector solveUpperTriangularLinearSystem(const Matrix &matrix, const vector &vc)
+    vector solveLowerTriangularLinearSystem(const Matrix &matrix, const vector &vc)
     {
-        if (vc.size() != matrix.m_height) {
+        if (vc.size() != matrix.m_height || matrix.m_width != matrix.m_height) {
             throw std::runtime_error("Impossible to solve a system with such dimensions");
         }
 
-        auto v = matrix.m_values;
-        v.insert(v.end(), vc.begin(), vc.end());
-        Matrix temp(matrix.m_height, matrix.m_height + 1, v);
-        return solveUpperTriangularLinearSystem(temp);
-    }
-
-    // Row
-
-    Matrix::Row Matrix::row(size_t i)
-    {
-        return Row(*this, i);
-    }
-
-    Matrix::Row::Row(Matrix &m, size_t row) : m_row(row), m_matrix(m)
-    {
-    }
-
-    Matrix::Row::Row(Matrix &m, size_t row, matrix_value coef) : m_row(row), m_matrix(m), m_coef(coef)
-    {
-    }
-
-    Matrix::Row Matrix::Row::operator-() const
-    {
-        return Row(m_matrix, m_row, -m_coef);
-    }
-
-    Matrix::Row Matrix::Row::operator*(matrix_value k) const
-    {
-        return Row(m_matrix, m_row, m_coef * k);
-    }
-
-    Matrix::Row Matrix::Row::operator/(matrix_value k) const
-    {
-        return Row(m_matrix, m_row, m_coef / k);
-    }
-
-    Matrix::Row &Matrix::Row::operator+=(const Row &row)
-    {
-        for (size_t i = 0; i < m_matrix.m_width; i++) {
-            m_matrix(m_row, i) += row(i);
-        }
-        return *this;
-    }
-
-    Matrix::Row &Matrix::Row::operator-=(const Row &row)
-    {
-        return (*this += -row);
-    }
-
-    Matrix::Row &Matrix::Row::operator*=(matrix_value k)
-    {
-        for (size_t i = 0; i < m_matrix.m_width; i++) {
-            m_matrix(m_row, i) *= k;
-        }
-        return *this;
-    }
-
-    Matrix::Row &Matrix::Row::operator/=(matrix_value k)
-    {
-        return (*this *= 1 / k);
-    }
-
-    matrix_value Matrix::Row::operator()(size_t j) const
-    {
-        return m_coef * m_matrix(m_row, j);
-    }
-
-    // Column
-
-    Matrix::Column Matrix::column(size_t j)
-    {
-        return Column(*this, j);
-    }
-
-    Matrix::Column::Column(Matrix &m, size_t column) : m_column(column), m_matrix(m)
-    {
-    }
-
-    Matrix::Column::Column(Matrix &m, size_t column, matrix_value coef) : m_column(column), m_matrix(m), m_coef(coef)
-    {
-    }
-
-    Matrix::Column Matrix::Column::operator-() const
-    {
-        return Column(m_matrix, m_column, -m_coef);
-    }
-
-    Matrix::Column Matrix::Column::operator*(matrix_value k) const
-    {
-        return Column(m_matrix, m_column, m_coef * k);
-    }
-
-    Matrix::Column Matrix::Column::operator/(matrix_value k) const
-    {
-        return Column(m_matrix, m_column, m_coef / k);
-    }
-
-    Matrix::Column &Matrix::Column::operator+=(const Column &column)
-    {
-        for (size_t i = 0; i < m_matrix.m_height; i++) {
-            m_matrix(i, m_column) += column(i);
-        }
-        return *this;
-    }
-
-    Matrix::Column &Matrix::Column::operator-=(const Column &column)
-    {
-        return (*this += -column);
-    }
-
-    matrix_value Matrix::Column::operator()(size_t i) const
-    {
-        return m_coef * m_matrix(i, m_column);
-    }
-
-    size_t Matrix::Column::mainElementIndex() const
-    {
-        return mainElementIndex(0, m_matrix.m_height);
-    }
-
-    size_t Matrix::Column::mainElementIndex(size_t from) const
-    {
-        return mainElementIndex(from, m_matrix.m_height);
+        vector result = vc;
+        substituteLower(matrix, result);
+        return result;
     }
 
-    size_t Matrix::Column::mainElementIndex(size_t from, size_t to) const
+    vector solveLowerTriangularLinearSystem(const Matrix &extendedMatrix)
     {
-        size_t index = from;
-        for (size_t i = from + 1; i < to; i++) {
-            if (std::abs(m_matrix(i, m_column)) > std::abs(m_matrix(from, m_column))) {
-                index = i;
-            }
+        if (extendedMatrix.m_width != extendedMatrix.m_height + 1) {
+            throw std::runtime_error("Impossible to solve a system with such dimensions");
         }
 
-        return index;
+        vector result(extendedMatrix.m_values.end() - extendedMatrix.m_height, extendedMatrix.m_values.end());
+        substituteLower(extendedMatrix, result);
+        return result;
     }
 
-    static std::pair<size_t, size_t> getLargestAboveDiagonal(const math::Matrix &matrix)
+    vector solveUpperTriangularLinearSystem(const Matrix &extendedMatrix)
     {
-        size_t ir = 0, jr = 1;
-        for (size_t j = 2; j < matrix.m_width; j++) {
-            for (size_t i = 0; i < j; i++) {
-                if (std::abs(matrix(i, j)) > std::abs(matrix(ir, jr))) {
-                    ir = i;
-                    jr = j;
-                }
-            }
+        if (extendedMatrix.m_width != extendedMatrix.m_height + 1) {
+            throw std::runtime_error("Impossible to solve a system with such dimensions");
         }
 
-        return {ir, jr};
+        vector result(extendedMatrix.m_values.end() - extendedMatrix.m_height, extendedMatrix.m_values.end());
+        substituteUpper(extendedMatrix, result);
+        return result;
     }
 
-    std::vector<std::pair<math::matrix_value, math::vector>> getJacobiEigenvectors(math::Matrix A, long double e, size_t *steps)
+    vector solveUpperTriangularLinearSystem(const Matrix &matrix, const vector &vc)
     {
-        auto X = math::Matrix::id(A.m_height);
-
-        if (steps) {
-            steps = 0;
-        }
-        while (true) {
-            auto [ik, jk] = getLargestAboveDiagonal(A);
-
-            if (std::abs(A(ik, jk)) < e) {
-                break;
-            }
-
-            if (steps) {
-                steps++;
-            }
-
-            auto d = std::sqrt((A(ik, ik) - A(jk, jk)) * (A(ik, ik) - A(jk, jk)) + 4.0 * A(ik, jk) * A(ik, jk));
-            auto c = std::sqrt((1.0 / 2.0) * (1 + std::abs(A(ik, ik) - A(jk, jk)) / d));
-            auto s = sign(A(ik, jk)) * sign(A(ik, ik) - A(jk, jk)) *
-                     std::sqrt((1.0 / 2.0) * (1.0 - std::abs(A(ik, ik) - A(jk, jk)) / d));
-
-            math::vector newValuesI(A.m_height);
-            for (size_t i = 0; i < A.m_height; i++) {
-                if (i == ik || i == jk) {
-                    continue;
-                }
-                // A(i, ik) = A(ik, i) = c * A(i, ik) + s * A(i, jk);
-                newValuesI[i] = c * A(i, ik) + s * A(i, jk);
-            }
-            newValuesI[ik] = c * c * A(ik, ik) + 2 * c * s * A(ik, jk) + s * s * A(jk, jk);
-            newValuesI[jk] = 0;
-
-            math::vector newValuesJ(A.m_height);
-            for (size_t i = 0; i < A.m_height; i++) {
-                if (i == ik || i == jk) {
-                    continue;
-                }
-                // A(i, jk) = A(jk, i) = c * A(i, jk) - s * A(i, ik);
-                newValuesJ[i] = c * A(i, jk) - s * A(i, ik);
-            }
-            newValuesJ[ik] = 0;
-            newValuesJ[jk] = s * s * A(ik, ik) - 2 * c * s * A(ik, jk) + c * c * A(jk, jk);
-
-            for (size_t i = 0; i < A.m_height; i++) {
-                A(i, ik) = A(ik, i) = newValuesI[i];
-                A(i, jk) = A(jk, i) = newValuesJ[i];
-            }
-
-            for (size_t i = 0; i < A.m_width; i++) {
-                if (i == ik || i == jk) {
-                    continue;
-                }
-                auto xii = X(i, ik) * c + X(i, jk) * s;
-                auto xij = -X(i, ik) * s + X(i, jk) * c;
-                X(i, ik) = xii;
-                X(i, jk) = xij;
-            }
-            auto xii = X(ik, ik) * c + X(ik, jk) * s;
-            auto xij = -X(ik, ik) * s + X(ik, jk) * c;
-            auto xji = X(jk, ik) * c + X(jk, jk) * s;
-            auto xjj = -X(jk, ik) * s + X(jk, jk) * c;
-            X(ik, ik) = xii;
-            X(ik, jk) = xij;
-            X(jk, ik) = xji;
-            X(jk, jk) = xjj;
-        }
-
-        std::vector<std::pair<math::matrix_value, math::vector>> result;
-        for (size_t i = 0; i < A.m_width; i++) {
-            math::vector eigenvector(A.m_height);
-            for (size_t j = 0; j < A.m_height; j++) {
-                eigenvector[j] = X(j, i);
-            }
-
-            result.push_back({A(i, i), eigenvector});
+        if (vc.size() != matrix.m_height || matrix.m_width != matrix.m_height) {
+            throw std::runtime_error("Impossible to solve a system with such dimensions");
         }
 
+        vector result = vc;
+        substituteUpper(matrix, result);
         return result;
     }
 
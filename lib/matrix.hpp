@@ -1,4 +1,5 @@
 #pragma once
+#include "blas.hpp"
 #include "math.hpp"
 #include <iostream>
 #include <utility>
@@ -6,9 +7,6 @@
 
 namespace math
 {
-    using matrix_value = value_t;
-    using vector = std::vector<matrix_value>;
-
     class Matrix
     {
       public:
@@ -27,12 +25,9 @@ namespace math
         Matrix &operator=(Matrix &&) = default;
 
       private:
-        class Row;
-        class Column;
-        Row row(size_t i);
-        Column column(size_t j);
-
-        void gaussForwards(bool chooseMainElement = true);
+        // Both work a column at a time over the column-major storage.
+        // Returns the sign of the row permutation
+        int gaussForwards(bool chooseMainElement = true);
         void gaussBackwards();
 
       public:
@@ -46,14 +41,27 @@ namespace math
         void swapRows(size_t i, size_t j);
         void swapColumns(size_t i, size_t j);
 
+        // Unpivoted Crout factorization into separate L and U (with unit
+        // diagonal); use math::LU to solve systems
         std::pair<Matrix, Matrix> decomposeLU() const;
         Matrix invert() const;
+        matrix_value determinant() const;
         void normalize();
 
         Matrix operator*(const Matrix &matrix) const;
         Matrix operator+(const Matrix &matrix) const;
         Matrix operator-(const Matrix &matrix) const;
+
+        // In place, without allocating; handy in iterative methods
+        Matrix &operator+=(const Matrix &matrix);
+        Matrix &operator-=(const Matrix &matrix);
+        Matrix &operator*=(matrix_value k);
+        // this += k * matrix
+        Matrix &addScaled(matrix_value k, const Matrix &matrix);
+        // this += a * b
+        Matrix &addProduct(const Matrix &a, const Matrix &b);
         matrix_value norm() const;
+        // By Arnoldi, see lanczos.hpp
         matrix_value spectralRadius() const;
 
         static Matrix id(size_t size);
@@ -72,15 +80,14 @@ namespace math
 
     vector solveLinearSystem(const Matrix &extendedMatrix, bool chooseMainElement = true);
     vector solveLinearSystem(const Matrix &matrix, const vector &vector, bool chooseMainElement = true);
+    // Factorizes on every call; keep a math::LU to solve many systems with
+    // the same matrix
     vector solveLinearSystemUsingLU(const Matrix &matrix, const vector &vector);
     vector solveLowerTriangularLinearSystem(const Matrix &extendedMatrix);
     vector solveLowerTriangularLinearSystem(const Matrix &matrix, const vector &vector);
     vector solveUpperTriangularLinearSystem(const Matrix &extendedMatrix);
     vector solveUpperTriangularLinearSystem(const Matrix &matrix, const vector &vector);
 
-    std::vector<std::pair<math::matrix_value, vector>>
-    getJacobiEigenvectors(math::Matrix A, long double e, size_t *steps = nullptr);
-
     const Matrix *for_wolfram(const Matrix &);
 } // namespace math
 
@@ -88,9 +95,7 @@ std::ostream &operator<<(std::ostream &stream, const math::vector &v);
 std::ostream &operator<<(std::ostream &stream, const math::Matrix *m);
 math::matrix_value operator*(const math::vector &k, const math::vector &v);
 math::Matrix operator*(math::matrix_value k, math::Matrix m);
-math::vector operator*(math::matrix_value k, math::vector v);
-math::vector operator/(math::vector v, math::matrix_value k);
+// Allocates the result; math::gemv writes into one that is already there
 math::vector operator*(const math::Matrix &m, const math::vector &v);
-math::vector operator+(const math::vector &v1, const math::vector &v2);
-math::vector operator-(const math::vector &v1, const math::vector &v2);
-math::matrix_value euclideanNorm(const math::vector &v);
\ No newline at end of file
+math::vector &operator*=(math::vector &v, math::matrix_value k);
+math::matrix_value euclideanNorm(const math::vector &v);
@@ -0,0 +1,90 @@
+#include "sparse.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace math
+{
+    SparseMatrix::SparseMatrix(size_t height, size_t width) : m_width(width), m_height(height), m_rowStarts(height + 1)
+    {
+    }
+
+    SparseMatrix::SparseMatrix(size_t height, size_t width, std::vector<element_t> elements)
+        : SparseMatrix(height, width)
+    {
+        std::sort(elements.begin(), elements.end(), [](const element_t &a, const element_t &b) {
+            return std::tie(std::get<0>(a), std::get<1>(a)) < std::tie(std::get<0>(b), std::get<1>(b));
+        });
+
+        for (auto &&[i, j, value] : elements) {
+            if (i >= height || j >= width) {
+                throw std::runtime_error("Element is outside of the matrix");
+            }
+
+            if (!m_columns.empty() && m_rowStarts[i + 1] && m_columns.back() == j) {
+                m_values.back() += value;
+                continue;
+            }
+            m_columns.push_back(j);
+            m_values.push_back(value);
+            m_rowStarts[i + 1]++;
+        }
+
+        for (size_t i = 0; i < height; i++) {
+            m_rowStarts[i + 1] += m_rowStarts[i];
+        }
+    }
+
+    SparseMatrix::SparseMatrix(const Matrix &matrix) : SparseMatrix(matrix.m_height, matrix.m_width)
+    {
+        for (size_t i = 0; i < m_height; i++) {
+            for (size_t j = 0; j < m_width; j++) {
+                if (matrix(i, j) != 0) {
+                    m_columns.push_back(j);
+                    m_values.push_back(matrix(i, j));
+                }
+            }
+            m_rowStarts[i + 1] = m_columns.size();
+        }
+    }
+
+    size_t SparseMatrix::find(size_t i, size_t j) const
+    {
+        auto begin = m_columns.begin() + m_rowStarts[i], end = m_columns.begin() + m_rowStarts[i + 1];
+        auto it = std::lower_bound(begin, end, j);
+        return it != end && *it == j ? it - m_columns.begin() : -1;
+    }
+
+    matrix_value SparseMatrix::operator()(size_t i, size_t j) const
+    {
+        size_t index = find(i, j);
+        return index == size_t(-1) ? 0 : m_values[index];
+    }
+
+    size_t SparseMatrix::nonZeros() const
+    {
+        return m_values.size();
+    }
+
+    void SparseMatrix::multiply(const vector &x, vector &y) const
+    {
+        if (x.size() != m_width) {
+            throw std::runtime_error("Impossible to multiply such matrix and vector");
+        }
+
+        y.resize(m_height);
+        for (size_t i = 0; i < m_height; i++) {
+            matrix_value sum = 0;
+            for (size_t k = m_rowStarts[i]; k < m_rowStarts[i + 1]; k++) {
+                sum += m_values[k] * x[m_columns[k]];
+            }
+            y[i] = sum;
+        }
+    }
+
+    vector SparseMatrix::operator*(const vector &x) const
+    {
+        vector y;
+        multiply(x, y);
+        return y;
+    }
+} // namespace math
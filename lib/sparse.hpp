@@ -0,0 +1,38 @@
+#pragma once
+#include "matrix.hpp"
+#include <tuple>
+#include <vector>
+
+namespace math
+{
+    // Compressed sparse rows: the non-zeros of row i are at positions
+    // m_rowStarts[i]..m_rowStarts[i + 1] of m_columns and m_values, in
+    // increasing column order
+    class SparseMatrix
+    {
+      public:
+        using element_t = std::tuple<size_t, size_t, matrix_value>;
+
+        size_t m_width, m_height;
+        std::vector<size_t> m_rowStarts;
+        std::vector<size_t> m_columns;
+        vector m_values;
+
+      public:
+        SparseMatrix(size_t height, size_t width);
+        // From (row, column, value) triples in any order; values at the same
+        // position are added up
+        SparseMatrix(size_t height, size_t width, std::vector<element_t> elements);
+        // Keeps the non-zero elements
+        explicit SparseMatrix(const Matrix &matrix);
+
+        matrix_value operator()(size_t i, size_t j) const;
+        // Index of (i, j) in m_values, or -1 if it isn't stored
+        size_t find(size_t i, size_t j) const;
+        size_t nonZeros() const;
+
+        // y = A x, without allocating
+        void multiply(const vector &x, vector &y) const;
+        vector operator*(const vector &x) const;
+    };
+} // namespace math
@@ -0,0 +1,48 @@
+#include "lib/AsyncSocket.hpp"
+#include "lib/EventLoop.hpp"
+#include "lib/NetworkStream.hpp"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Fetches several paths concurrently on one thread; each fetch reads like
+// blocking code but suspends until its socket operations complete.
+Task<void> fetch(EventLoop &loop, std::string path, int &pending)
+{
+    AsyncSocket socket = co_await AsyncSocket::connect(loop, "localhost", "8080");
+
+    std::ostringstream request;
+    request << "GET " << path << " HTTP/1.1" << net::endl
+            << "Host: localhost" << net::endl
+            << "Connection: close" << net::endrequest;
+    co_await socket.write(request.view());
+
+    std::string response;
+    char buffer[DEFAULT_INPUT_BUFFER_SIZE];
+    while (size_t read = co_await socket.read(buffer)) {
+        response.append(buffer, read);
+    }
+
+    std::cout << path << ": " << response.substr(0, response.find("\r\n")) << " (" << response.size() << " bytes)"
+              << std::endl;
+
+    if (!--pending) {
+        loop.stop();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> paths(argv + 1, argv + argc);
+    if (paths.empty()) {
+        paths = {"/", "/.gitignore", "/makefile", "/assets/bear.jpg"};
+    }
+
+    auto loop = EventLoop::create();
+    int pending = paths.size();
+    for (auto &&path : paths) {
+        spawn(fetch(*loop, path, pending));
+    }
+    loop->run();
+}
@@ -0,0 +1,38 @@
+#include "lib/AsyncHttpServer.hpp"
+#include "lib/EventLoop.hpp"
+#include "lib/Logging.hpp"
+#include "lib/Router.hpp"
+#include <filesystem>
+#include <iostream>
+
+int main(int argc, char *argv[])
+{
+    ServerMetrics metrics;
+    Router router;
+    router.get("/metrics", [&metrics](const Request &request) {
+        return std::unique_ptr<Response>(new StringResponse(metrics.render(), ServerMetrics::CONTENT_TYPE));
+    });
+    router.get("/*", [](const Request &request) {
+        HTTP_LOG(request);
+
+        std::filesystem::path path {"." + request.path.substr(0, request.path.find('?'))};
+        if (std::filesystem::is_directory(path)) {
+            path /= "index.html";
+        }
+
+        if (!std::filesystem::is_regular_file(path)) {
+            throw NotFoundError();
+        }
+
+        return std::unique_ptr<Response>(new FileResponse(path));
+    });
+
+    auto loop = EventLoop::create(argc > 1 ? parseIoBackend(argv[1]) : IoBackend::Auto);
+    std::cout << "Serving on port 8080 using " << loop->name() << std::endl;
+
+    HttpServerOptions options;
+    options.metrics = &metrics;
+    AsyncHttpServer server(*loop, "8080", router, options);
+    server.start();
+    loop->run();
+}
@@ -1,15 +1,44 @@
-#include "lib/NetworkStream.hpp"
+#include "lib/HttpClient.hpp"
 #include <iostream>
-#include <sys/select.h>
-#include <sys/time.h>
+#include <string>
+#include <vector>
 
+// Usage: http-client [host [port [paths...]]]
+//
+// Streams the first path to stdout, then fetches the rest in one pipeline
+// over the pooled connection.
 int main(int argc, char *argv[])
 {
-    NetworkStream stream("localhost");
+    std::string host = argc > 1 ? argv[1] : "localhost";
+    std::string port = argc > 2 ? argv[2] : "80";
+    std::vector<std::string> paths(argv + std::min(argc, 3), argv + argc);
+    if (paths.empty()) {
+        paths = {"/.gitignore"};
+    }
 
-    stream << "GET /.gitignore HTTP/1.1" << net::endl
-           << "Host: localhost" << net::endl
-           << "Connection: close" << net::endrequest << std::flush;
+    HttpClient client;
 
-    std::cout << stream.rdbuf() << std::endl;
-}
\ No newline at end of file
+    {
+        ResponseReader reader = client.send(host, port, {.method = "GET", .path = paths[0]});
+        std::cout << reader.head().status << ' ' << reader.head().message << std::endl;
+
+        char buffer[4096];
+        while (size_t read = reader.read(buffer)) {
+            std::cout.write(buffer, read);
+        }
+        std::cout << std::endl;
+    }
+
+    if (paths.size() > 1) {
+        std::vector<Request> requests;
+        for (auto &&path = paths.begin() + 1; path != paths.end(); ++path) {
+            requests.push_back({.method = "GET", .path = *path});
+        }
+
+        std::vector<ClientResponse> responses = client.pipeline(host, port, requests);
+        for (size_t i = 0; i < responses.size(); i++) {
+            std::cout << requests[i].path << ": " << responses[i].status << ' ' << responses[i].message << " ("
+                      << responses[i].body.size() << " bytes)" << std::endl;
+        }
+    }
+}
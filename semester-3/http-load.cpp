@@ -0,0 +1,381 @@
+#include "lib/LatencyHistogram.hpp"
+#include "lib/Logging.hpp"
+#include "lib/NetworkStream.hpp"
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// wrk-style HTTP load generator:
+//
+//     http-load [-t threads] [-c connections] [-d seconds] [-p pipeline]
+//               [-R requests/s] [-k 0|1] [-L] [host [port [path]]]
+//
+// Without -R every connection keeps `pipeline` requests in flight and the
+// tool measures peak throughput. With -R requests are issued on a fixed
+// schedule and latency is measured from the time each request *should*
+// have been sent, so a stalled server can't hide its stalls by slowing the
+// client down (coordinated omission).
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string host = "localhost";
+    std::string port = "80";
+    std::string path = "/";
+    int threads = 2;
+    int connections = 16;
+    int pipeline = 1;
+    double duration = 10;
+    double rate = 0;
+    bool keepAlive = true;
+    bool printDistribution = false;
+};
+
+struct Stats {
+    LatencyHistogram latency;
+    uint64_t requests = 0;
+    uint64_t bytes = 0;
+    uint64_t statusErrors = 0;
+    uint64_t socketErrors = 0;
+
+    void merge(const Stats &other)
+    {
+        latency.merge(other.latency);
+        requests += other.requests;
+        bytes += other.bytes;
+        statusErrors += other.statusErrors;
+        socketErrors += other.socketErrors;
+    }
+};
+
+struct Connection {
+    std::unique_ptr<NetworkStream> stream;
+    // Send times (intended ones in fixed-rate mode) of unanswered requests
+    std::deque<Clock::time_point> inFlight;
+    bool closing = false;
+};
+
+// Unlike istream::ignore(), never looks past the last byte, which would
+// block until the server sends something more
+static void discard(std::istream &stream, size_t count)
+{
+    char buffer[4096];
+    while (count && stream.read(buffer, std::min(count, sizeof(buffer)))) {
+        count -= stream.gcount();
+    }
+}
+
+// Reads one response, discarding the body. Returns the status code, or 0
+// if the connection broke.
+static int readResponse(NetworkStream &stream, uint64_t &bytes, bool &closing)
+{
+    std::string line;
+    if (!std::getline(stream, line)) {
+        return 0;
+    }
+    bytes += line.size() + 1;
+
+    // "HTTP/1.1 200\r" at the least, the reason phrase being optional
+    int status = 0;
+    if (line.size() >= 12 && line.starts_with("HTTP/")) {
+        status = std::atoi(line.c_str() + 9);
+    }
+
+    size_t contentLength = 0;
+    bool chunked = false;
+    while (std::getline(stream, line) && line != "\r") {
+        bytes += line.size() + 1;
+
+        size_t colon = line.find(':');
+        std::string name = line.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        std::string value = colon == std::string::npos ? "" : line.substr(colon + 1);
+
+        if (name == "content-length") {
+            contentLength = std::stoul(value);
+        } else if (name == "transfer-encoding") {
+            chunked = value.find("chunked") != std::string::npos;
+        } else if (name == "connection") {
+            closing = value.find("close") != std::string::npos;
+        }
+    }
+    bytes += 2;
+
+    if (chunked) {
+        while (std::getline(stream, line)) {
+            size_t size = std::stoul(line, nullptr, 16);
+            discard(stream, size + 2);
+            bytes += line.size() + 1 + size + 2;
+            if (!size) break;
+        }
+    } else {
+        discard(stream, contentLength);
+        bytes += contentLength;
+    }
+
+    return stream ? status : 0;
+}
+
+class Worker
+{
+  private:
+    const Options &options;
+    const std::string request;
+    std::vector<Connection> connections;
+    size_t nextConnection = 0;
+
+    void connect(Connection &connection)
+    {
+        connection.inFlight.clear();
+        connection.closing = false;
+        connection.stream.reset();
+        try {
+            connection.stream.reset(new NetworkStream(options.host.c_str(), options.port));
+        } catch (const std::runtime_error &e) {
+            stats.socketErrors++;
+        }
+    }
+
+    bool send(Connection &connection, Clock::time_point sentAt)
+    {
+        if (!connection.stream) {
+            connect(connection);
+            if (!connection.stream) return false;
+        }
+        connection.stream->write(request.data(), request.size());
+        connection.inFlight.push_back(sentAt);
+        return true;
+    }
+
+    bool canSend(const Connection &connection) const
+    {
+        size_t limit = options.keepAlive ? options.pipeline : 1;
+        return !connection.closing && connection.inFlight.size() < limit;
+    }
+
+    Connection *findFreeConnection()
+    {
+        for (size_t i = 0; i < connections.size(); i++) {
+            Connection &connection = connections[(nextConnection + i) % connections.size()];
+            if (canSend(connection)) {
+                nextConnection = (nextConnection + i + 1) % connections.size();
+                return &connection;
+            }
+        }
+        return nullptr;
+    }
+
+    void receive(Connection &connection)
+    {
+        // Everything already buffered can be parsed without another poll()
+        do {
+            uint64_t bytes = 0;
+            int status = 0;
+            try {
+                status = readResponse(*connection.stream, bytes, connection.closing);
+            } catch (const std::exception &e) {
+                // Malformed numbers in the head
+            }
+            if (!status) {
+                stats.socketErrors++;
+                connect(connection);
+                return;
+            }
+
+            auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                Clock::now() - connection.inFlight.front()
+            );
+            connection.inFlight.pop_front();
+
+            stats.latency.record(latency.count());
+            stats.requests++;
+            stats.bytes += bytes;
+            if (status >= 400) stats.statusErrors++;
+        } while (!connection.inFlight.empty() && connection.stream->rdbuf()->in_avail() > 0);
+
+        if ((connection.closing || !options.keepAlive) && connection.inFlight.empty()) {
+            connect(connection);
+        }
+    }
+
+  public:
+    Stats stats;
+
+    Worker(const Options &options, const std::string &request, int connectionCount)
+        : options(options), request(request), connections(connectionCount)
+    {
+        for (auto &&connection : connections) {
+            connect(connection);
+        }
+    }
+
+    void run(Clock::time_point start, double rate)
+    {
+        using Seconds = std::chrono::duration<double>;
+        const Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(Seconds(options.duration));
+        const auto interval = rate ? std::chrono::duration_cast<Clock::duration>(Seconds(1 / rate)) : Clock::duration::zero();
+        Clock::time_point nextSend = start;
+        std::vector<pollfd> fds;
+        std::vector<Connection *> polled;
+
+        for (Clock::time_point now = Clock::now(); now < end; now = Clock::now()) {
+            if (rate) {
+                // A request that finds no free connection keeps its slot in
+                // the schedule, and its latency keeps growing meanwhile
+                while (nextSend <= now) {
+                    Connection *connection = findFreeConnection();
+                    if (!connection || !send(*connection, nextSend)) break;
+                    nextSend += interval;
+                }
+            } else {
+                for (auto &&connection : connections) {
+                    while (canSend(connection) && send(connection, now)) {
+                    }
+                }
+            }
+
+            fds.clear();
+            polled.clear();
+            for (auto &&connection : connections) {
+                if (connection.inFlight.empty()) continue;
+
+                if (!connection.stream->flush()) {
+                    stats.socketErrors++;
+                    connect(connection);
+                    continue;
+                }
+                fds.push_back({connection.stream->socket(), POLLIN, 0});
+                polled.push_back(&connection);
+            }
+
+            // Once every connection is busy, a send that is due has to wait
+            // for a response anyway; waking up for it would only spin
+            bool canSendDue = nextSend > Clock::now() ||
+                              std::any_of(connections.begin(), connections.end(),
+                                          [this](const Connection &connection) { return canSend(connection); });
+            auto wakeUp = rate && canSendDue ? std::min(nextSend, end) : end;
+            auto timeout = std::max(wakeUp - Clock::now(), Clock::duration::zero());
+            if (fds.empty()) {
+                std::this_thread::sleep_for(timeout);
+                continue;
+            }
+
+            // ppoll() rather than poll(): a millisecond timeout would delay
+            // scheduled sends enough to show up in the latencies
+            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+            timespec timeoutSpec = {
+                .tv_sec = seconds.count(),
+                .tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout - seconds).count(),
+            };
+            if (ppoll(fds.data(), fds.size(), &timeoutSpec, nullptr) <= 0) {
+                continue;
+            }
+
+            for (size_t i = 0; i < fds.size(); i++) {
+                if (fds[i].revents) receive(*polled[i]);
+            }
+        }
+    }
+};
+
+static void usage(const char *program)
+{
+    std::cout << "Usage: " << program
+              << " [-t threads] [-c connections] [-d seconds] [-p pipeline] [-R requests/s] [-k 0|1] [-L]"
+                 " [host [port [path]]]"
+              << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    int option;
+    while ((option = getopt(argc, argv, "t:c:d:p:R:k:Lh")) != -1) {
+        switch (option) {
+            case 't': options.threads = std::stoi(optarg); break;
+            case 'c': options.connections = std::stoi(optarg); break;
+            case 'd': options.duration = std::stod(optarg); break;
+            case 'p': options.pipeline = std::stoi(optarg); break;
+            case 'R': options.rate = std::stod(optarg); break;
+            case 'k': options.keepAlive = std::stoi(optarg); break;
+            case 'L': options.printDistribution = true; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind < argc) options.host = argv[optind++];
+    if (optind < argc) options.port = argv[optind++];
+    if (optind < argc) options.path = argv[optind++];
+
+    options.threads = std::clamp(options.threads, 1, std::max(options.connections, 1));
+    options.pipeline = std::max(options.pipeline, 1);
+
+    std::string request = "GET " + options.path + " HTTP/1.1\r\nHost: " + options.host + "\r\n";
+    if (!options.keepAlive) request += "Connection: close\r\n";
+    request += "\r\n";
+
+    std::cout << "Running " << options.duration << "s test @ http://" << options.host << ':' << options.port
+              << options.path << std::endl
+              << "  " << options.threads << " threads and " << options.connections << " connections";
+    if (options.rate) std::cout << ", " << options.rate << " requests/s";
+    if (options.pipeline > 1) std::cout << ", pipeline depth " << options.pipeline;
+    std::cout << std::endl;
+
+    // NetworkStream and AddrInfo log every connection
+    setHttpLogging(false);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < options.threads; i++) {
+        int connections = options.connections / options.threads + (i < options.connections % options.threads);
+        workers.emplace_back(new Worker(options, request, connections));
+    }
+
+    std::vector<std::thread> threads;
+    Clock::time_point start = Clock::now();
+    for (auto &&worker : workers) {
+        threads.emplace_back(&Worker::run, worker.get(), start, options.rate / options.threads);
+    }
+    for (auto &&thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    setHttpLogging(true);
+
+    Stats total;
+    for (auto &&worker : workers) {
+        total.merge(worker->stats);
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "  Latency     avg " << total.latency.mean() / 1000 << "ms, stdev " << total.latency.stddev() / 1000
+              << "ms, max " << total.latency.max() / 1000.0 << "ms" << std::endl;
+    std::cout << "  Latency distribution" << (options.rate ? " (corrected for coordinated omission)" : "") << std::endl;
+    for (double percentile : {50.0, 75.0, 90.0, 99.0, 99.9, 99.99, 99.999, 100.0}) {
+        std::cout << std::setw(10) << std::setprecision(3) << percentile << "%  " << std::setprecision(2)
+                  << total.latency.valueAt(percentile) / 1000.0 << "ms" << std::endl;
+    }
+    if (options.printDistribution) {
+        std::cout << std::endl;
+        total.latency.print(std::cout, 1000);
+        std::cout << std::endl;
+    }
+
+    std::cout << "  " << total.requests << " requests in " << elapsed << "s, " << total.bytes / 1024.0 / 1024.0
+              << "MB read" << std::endl;
+    if (total.socketErrors || total.statusErrors) {
+        std::cout << "  Socket errors: " << total.socketErrors << ", non-2xx/3xx responses: " << total.statusErrors
+                  << std::endl;
+    }
+    std::cout << "Requests/sec: " << total.requests / elapsed << std::endl
+              << "Transfer/sec: " << total.bytes / elapsed / 1024 / 1024 << "MB" << std::endl;
+}
@@ -1,17 +1,20 @@
 #include "lib/HttpServer.hpp"
+#include "lib/Logging.hpp"
+#include "lib/Router.hpp"
 #include <filesystem>
 #include <iostream>
 
 int main()
 {
-    HttpServer server("80", [](const Request &request) {
-        std::cout << request;
-
-        if (request.method != "GET") {
-            throw MethodNotAllowedError();
-        }
+    ServerMetrics metrics;
+    Router router;
+    router.get("/metrics", [&metrics](const Request &request) {
+        return std::unique_ptr<Response>(new StringResponse(metrics.render(), ServerMetrics::CONTENT_TYPE));
+    });
+    router.get("/*", [](const Request &request) {
+        HTTP_LOG(request);
 
-        std::filesystem::path path {"." + request.path};
+        std::filesystem::path path {"." + request.path.substr(0, request.path.find('?'))};
         if (std::filesystem::is_directory(path)) {
             path /= "index.html";
         }
@@ -22,4 +25,8 @@ int main()
 
         return std::unique_ptr<Response>(new FileResponse(path));
     });
-}
\ No newline at end of file
+
+    HttpServerOptions options;
+    options.metrics = &metrics;
+    HttpServer server("80", router, options);
+}
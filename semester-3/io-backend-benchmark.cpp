@@ -0,0 +1,103 @@
+#include "lib/AsyncHttpServer.hpp"
+#include "lib/AsyncSocket.hpp"
+#include "lib/EventLoop.hpp"
+#include "lib/Logging.hpp"
+#include "lib/NetworkStream.hpp"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Serves a small response and hammers it with keep-alive connections from
+// the same loop, so the only thing changing between runs is the I/O backend.
+//
+// Usage: io-backend-benchmark [connections] [requests per connection]
+
+constexpr const char *PORT = "8081";
+
+struct Stats {
+    AsyncHttpServer &server;
+    int pending;
+    size_t requests = 0;
+    size_t bytes = 0;
+};
+
+Task<void> client(EventLoop &loop, int requests, Stats &stats)
+{
+    AsyncSocket socket = co_await AsyncSocket::connect(loop, "localhost", PORT);
+
+    std::ostringstream stream;
+    stream << "GET / HTTP/1.1" << net::endl << "Host: localhost" << net::endrequest;
+    const std::string request = stream.str();
+
+    std::string buffer;
+    char chunk[DEFAULT_INPUT_BUFFER_SIZE];
+    for (int i = 0; i < requests; i++) {
+        co_await socket.write(request);
+
+        size_t headEnd;
+        while ((headEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+            size_t read = co_await socket.read(chunk);
+            if (!read) throw std::runtime_error("Server closed the connection");
+            buffer.append(chunk, read);
+        }
+
+        size_t lengthStart = buffer.find("Content-Length: ") + 16;
+        size_t responseSize = headEnd + 4 + std::stoul(buffer.substr(lengthStart, headEnd - lengthStart));
+        while (buffer.size() < responseSize) {
+            size_t read = co_await socket.read(chunk);
+            if (!read) throw std::runtime_error("Server closed the connection");
+            buffer.append(chunk, read);
+        }
+
+        stats.bytes += responseSize;
+        stats.requests++;
+        buffer.erase(0, responseSize);
+    }
+
+    // The server then stops the loop once its coroutines are gone, so
+    // nothing of this run is left for the next one
+    if (!--stats.pending) {
+        stats.server.stop();
+    }
+}
+
+void benchmark(IoBackend backend, int connections, int requests)
+{
+    // The server logs every connection; keep that out of the measurement
+    setHttpLogging(false);
+    auto loop = EventLoop::create(backend);
+
+    AsyncHttpServer server(*loop, PORT, [](const Request &) {
+        return std::unique_ptr<Response>(new StringResponse("Hello, world!\n", "text/plain"));
+    });
+    server.start();
+
+    Stats stats {server, connections};
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < connections; i++) {
+        spawn(client(*loop, requests, stats));
+    }
+
+    loop->run();
+    setHttpLogging(true);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << loop->name() << ": " << stats.requests << " requests in " << elapsed.count() << "s, "
+              << stats.requests / elapsed.count() << " req/s, " << stats.bytes / elapsed.count() / 1024 / 1024
+              << " MiB/s" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    int connections = argc > 1 ? std::stoi(argv[1]) : 64;
+    int requests = argc > 2 ? std::stoi(argv[2]) : 1000;
+
+    for (IoBackend backend : {IoBackend::Epoll, IoBackend::IoUring}) {
+        try {
+            benchmark(backend, connections, requests);
+        } catch (const std::runtime_error &e) {
+            std::cout << e.what() << std::endl;
+        }
+    }
+}
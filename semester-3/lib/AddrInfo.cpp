@@ -1,9 +1,10 @@
 #include "AddrInfo.hpp"
+#include "Logging.hpp"
 
 AddrInfo::AddrInfo(const char *hostname, const std::string &servname, const addrinfo &hints)
 {
     if (hostname) {
-        std::cout << "Retrieving host info for \"" << hostname << '"' << std::endl;
+        HTTP_LOG("Retrieving host info for \"" << hostname << '"');
     }
 
     int status = getaddrinfo(hostname, servname.c_str(), &hints, &addrInfo);
@@ -15,4 +16,34 @@ AddrInfo::AddrInfo(const char *hostname, const std::string &servname, const addr
 AddrInfo::~AddrInfo()
 {
     freeaddrinfo(addrInfo);
-}
\ No newline at end of file
+}
+
+AddrInfoCache::AddrInfoCache(Clock::duration ttl) : ttl(ttl)
+{
+}
+
+std::shared_ptr<const AddrInfo> AddrInfoCache::resolve(const std::string &hostname, const std::string &servname)
+{
+    auto key = std::make_pair(hostname, servname);
+    {
+        std::lock_guard lock(mutex);
+        auto &&it = entries.find(key);
+        if (it != entries.end() && it->second.expires > Clock::now()) {
+            return it->second.addrInfo;
+        }
+    }
+
+    // Resolve without holding the lock; a concurrent miss just resolves twice
+    const addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
+    std::shared_ptr<const AddrInfo> addrInfo(new AddrInfo(hostname.c_str(), servname, hints));
+
+    std::lock_guard lock(mutex);
+    entries[key] = {addrInfo, Clock::now() + ttl};
+    return addrInfo;
+}
+
+void AddrInfoCache::forget(const std::string &hostname, const std::string &servname)
+{
+    std::lock_guard lock(mutex);
+    entries.erase(std::make_pair(hostname, servname));
+}
@@ -1,8 +1,14 @@
 #pragma once
 #include <arpa/inet.h>
-#include <iostream>
 #include <netdb.h>
 
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
 struct AddrInfo {
   private:
     addrinfo *addrInfo = nullptr;
@@ -34,5 +40,31 @@ struct AddrInfo {
     }
 
     AddrInfo(const char *hostname, const std::string &servname, const addrinfo &hints);
+    AddrInfo(const AddrInfo &) = delete;
+    AddrInfo &operator=(const AddrInfo &) = delete;
     ~AddrInfo();
+};
+
+// Remembers resolved stream-socket addresses for `ttl`, so that opening
+// many connections to the same host costs a single getaddrinfo() call.
+// Safe to share between threads.
+class AddrInfoCache
+{
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::shared_ptr<const AddrInfo> addrInfo;
+        Clock::time_point expires;
+    };
+
+    const Clock::duration ttl;
+    std::mutex mutex;
+    std::map<std::pair<std::string, std::string>, Entry> entries;
+
+  public:
+    AddrInfoCache(Clock::duration ttl = std::chrono::seconds(60));
+
+    std::shared_ptr<const AddrInfo> resolve(const std::string &hostname, const std::string &servname);
+    void forget(const std::string &hostname, const std::string &servname);
 };
\ No newline at end of file
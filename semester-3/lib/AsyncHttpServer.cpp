@@ -0,0 +1,186 @@
+#include "AsyncHttpServer.hpp"
+#include "Logging.hpp"
+#include <sys/socket.h>
+
+#include <iostream>
+#include <sstream>
+
+AsyncHttpServer::AsyncHttpServer(EventLoop &loop, const std::string &port, RequestHandler handler,
+                                 const HttpServerOptions &options)
+    : loop(loop), listener(AsyncSocket::listen(loop, port, options.backlog)), handler(std::move(handler)),
+      options(options)
+{
+}
+
+void AsyncHttpServer::start()
+{
+    spawn(acceptConnections());
+}
+
+void AsyncHttpServer::stop()
+{
+    stopping = true;
+    // Fails the pending accept
+    shutdown(listener.socket(), SHUT_RDWR);
+    for (int fd : connections) {
+        shutdown(fd, SHUT_RDWR);
+    }
+    finished();
+}
+
+void AsyncHttpServer::finished()
+{
+    if (stopping && !accepting && connections.empty()) {
+        loop.stop();
+    }
+}
+
+Task<void> AsyncHttpServer::acceptConnections()
+{
+    accepting = true;
+    try {
+        while (!stopping) {
+            AsyncSocket socket = co_await listener.accept();
+            if (stopping) break;
+            HTTP_LOG("> Accepted connection");
+            spawn(handle(std::move(socket), ServerMetrics::Clock::now()));
+        }
+    } catch (const std::runtime_error &e) {
+        if (!stopping) {
+            accepting = false;
+            throw;
+        }
+    }
+    accepting = false;
+    finished();
+}
+
+Task<void> AsyncHttpServer::handle(AsyncSocket socket, ServerMetrics::Clock::time_point acceptedAt)
+{
+    // Destroyed before the socket parameter, so the descriptor is forgotten
+    // before it is closed and can be reused
+    struct Registration {
+        AsyncHttpServer &server;
+        int fd;
+
+        ~Registration()
+        {
+            server.connections.erase(fd);
+            server.finished();
+        }
+    } registration {*this, socket.socket()};
+    connections.insert(socket.socket());
+
+    ServerMetrics::Recorder metrics(options.metrics);
+    metrics.start(acceptedAt);
+    metrics.lap(ServerMetrics::Phase::Accept);
+
+    // The same deadlines as in HttpServer: shutting the socket down makes
+    // the pending read or write return, and the coroutine finish
+    SocketDeadline deadline(timers, socket.socket());
+    std::string buffer;
+    char chunk[DEFAULT_INPUT_BUFFER_SIZE];
+    // Responses are only sent once the socket has to be read again, so
+    // those to pipelined requests go out together in one write
+    std::string pending;
+
+    while (true) {
+        // Pipelined requests may already be waiting in the buffer
+        if (!buffer.empty()) {
+            metrics.start();
+        }
+
+        Request request;
+        std::ostringstream output;
+        bool closeConnection = false;
+        int status;
+
+        try {
+            deadline.set(buffer.empty() ? options.idleTimeout : options.headerTimeout);
+            // Only the bytes after `scanned` can hold the end of the head,
+            // so each read is searched once
+            size_t scanned = 0, headEnd;
+            while ((headEnd = buffer.find("\r\n\r\n", scanned)) == std::string::npos) {
+                if (buffer.size() >= options.maxHeaderBytes) {
+                    throw RequestHeaderFieldsTooLargeError();
+                }
+                // The terminator may be split between two reads
+                scanned = buffer.size() < 3 ? 0 : buffer.size() - 3;
+
+                if (!pending.empty()) {
+                    deadline.set(options.writeTimeout);
+                    co_await socket.write(pending);
+                    pending.clear();
+                    deadline.set(buffer.empty() ? options.idleTimeout : options.headerTimeout);
+                }
+                size_t read = co_await socket.read(chunk);
+                if (!read) co_return;
+                if (buffer.empty()) {
+                    metrics.start();
+                    deadline.set(options.headerTimeout);
+                }
+                buffer.append(chunk, read);
+            }
+            if (headEnd + 4 > options.maxHeaderBytes) {
+                throw RequestHeaderFieldsTooLargeError();
+            }
+
+            std::istringstream head(buffer.substr(0, headEnd + 4));
+            buffer.erase(0, headEnd + 4);
+
+            readRequestHead(head, request);
+            size_t contentLength = getContentLength(request);
+            if (contentLength > options.maxBodyBytes) {
+                throw PayloadTooLargeError();
+            }
+            deadline.set(options.bodyTimeout);
+            while (buffer.size() < contentLength) {
+                if (!pending.empty()) {
+                    co_await socket.write(pending);
+                    pending.clear();
+                }
+                size_t read = co_await socket.read(chunk);
+                if (!read) co_return;
+                buffer.append(chunk, read);
+            }
+            request.body = buffer.substr(0, contentLength);
+            buffer.erase(0, contentLength);
+            deadline.cancel();
+            metrics.lap(ServerMetrics::Phase::Parse);
+
+            std::unique_ptr<Response> response = handler(request);
+            metrics.lap(ServerMetrics::Phase::Handler);
+            writeResponse(output, *response, request, options.compression);
+            status = response->status;
+        } catch (const HttpError &e) {
+            output.str("");
+            output << e;
+            closeConnection = e.closeConnection;
+            status = e.status;
+        } catch (const std::exception &e) {
+            // A failing handler gets a 500, after the responses already
+            // waiting for the requests pipelined before it
+            HTTP_LOG("> Request failed: \"" << e.what() << '"');
+            InternalServerError error;
+            output.str("");
+            output << error;
+            closeConnection = error.closeConnection;
+            status = error.status;
+        }
+
+        auto &&it = request.headers.find("connection");
+        if (it != request.headers.end() && it->second == "close") {
+            closeConnection = true;
+        }
+
+        pending += output.view();
+        metrics.lap(ServerMetrics::Phase::Write);
+        metrics.countResponse(status);
+
+        if (closeConnection) {
+            deadline.set(options.writeTimeout);
+            co_await socket.write(pending);
+            co_return;
+        }
+    }
+}
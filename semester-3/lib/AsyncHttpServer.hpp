@@ -0,0 +1,41 @@
+#pragma once
+#include "AsyncSocket.hpp"
+#include "EventLoop.hpp"
+#include "HttpServer.hpp"
+#include <string>
+#include <unordered_set>
+
+// HttpServer counterpart built on AsyncSocket: every connection is a
+// coroutine, so a single thread serves many keep-alive clients at once.
+// Handlers are the same RequestHandler (or Router) used by HttpServer, and
+// so are the options, except for those about threads and stream buffers.
+class AsyncHttpServer
+{
+  private:
+    EventLoop &loop;
+    AsyncSocket listener;
+    RequestHandler handler;
+    const HttpServerOptions options;
+    TimerWheel timers;
+
+    // What is still running on the loop, so that stop() can wait for it
+    bool accepting = false;
+    bool stopping = false;
+    std::unordered_set<int> connections;
+
+    Task<void> acceptConnections();
+    Task<void> handle(AsyncSocket socket, ServerMetrics::Clock::time_point acceptedAt);
+    // Stops the loop if this was the last thing stop() waited for
+    void finished();
+
+  public:
+    AsyncHttpServer(EventLoop &loop, const std::string &port, RequestHandler handler,
+                    const HttpServerOptions &options = {});
+
+    // Starts accepting connections; they are served while loop.run() runs
+    void start();
+    // Stops accepting and shuts every connection down. Their coroutines
+    // finish on the loop, and once the last one has, the loop is stopped,
+    // so nothing of the server is left suspended on it.
+    void stop();
+};
@@ -0,0 +1,150 @@
+#include "AsyncSocket.hpp"
+#include "AddrInfo.hpp"
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+static std::runtime_error socketError(const std::string &what)
+{
+    return std::runtime_error(what + ": \"" + std::strerror(errno) + '"');
+}
+
+AsyncSocket::AsyncSocket(EventLoop &loop, int fd) : loop(&loop), fd(fd)
+{
+    loop.add(fd);
+}
+
+AsyncSocket::AsyncSocket(AsyncSocket &&socket) noexcept : loop(socket.loop), fd(std::exchange(socket.fd, -1))
+{
+}
+
+AsyncSocket &AsyncSocket::operator=(AsyncSocket &&socket) noexcept
+{
+    if (this != &socket) {
+        close();
+        loop = socket.loop;
+        fd = std::exchange(socket.fd, -1);
+    }
+    return *this;
+}
+
+AsyncSocket::~AsyncSocket()
+{
+    close();
+}
+
+void AsyncSocket::close()
+{
+    if (fd >= 0) {
+        loop->remove(fd);
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+int AsyncSocket::socket() const
+{
+    return fd;
+}
+
+AsyncSocket AsyncSocket::listen(EventLoop &loop, const std::string &port, int backlog)
+{
+    const addrinfo hints = {.ai_flags = AI_PASSIVE, .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
+    const AddrInfo addrInfo(nullptr, port, hints);
+
+    int fd = ::socket(addrInfo.ai_family(), addrInfo.ai_socktype(), addrInfo.ai_protocol());
+    if (fd < 0) {
+        throw socketError("Unable to open socket");
+    }
+    AsyncSocket listener(loop, fd);
+
+    int yes = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes)) < 0) {
+        throw socketError("Unable to set socket option");
+    }
+    if (bind(fd, addrInfo.ai_addr(), addrInfo.ai_addrlen()) < 0) {
+        throw socketError("Unable to bind to port");
+    }
+    if (::listen(fd, backlog) < 0) {
+        throw socketError("listen() call failed");
+    }
+
+    return listener;
+}
+
+Task<AsyncSocket> AsyncSocket::connect(EventLoop &loop, const char *hostname, std::string service)
+{
+    const addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
+    const AddrInfo addrInfo(hostname, service, hints);
+
+    int fd = ::socket(addrInfo.ai_family(), addrInfo.ai_socktype(), addrInfo.ai_protocol());
+    if (fd < 0) {
+        throw socketError("Unable to open socket");
+    }
+    AsyncSocket socket(loop, fd);
+
+    int result = co_await loop.connect(fd, addrInfo.ai_addr(), addrInfo.ai_addrlen());
+    if (result < 0) {
+        errno = -result;
+        throw socketError("Unable to connect");
+    }
+
+    co_return socket;
+}
+
+Task<AsyncSocket> AsyncSocket::accept()
+{
+    while (true) {
+        int client = co_await loop->accept(fd);
+        if (client >= 0) {
+            co_return AsyncSocket(*loop, client);
+        }
+
+        if (client != -EINTR && client != -ECONNABORTED) {
+            errno = -client;
+            throw socketError("Unable to accept connection");
+        }
+    }
+}
+
+Task<size_t> AsyncSocket::read(std::span<char> buffer)
+{
+    ssize_t bytes = co_await loop->recv(fd, buffer);
+    if (bytes >= 0) {
+        co_return bytes;
+    }
+    if (bytes == -ECONNRESET) {
+        co_return 0;
+    }
+
+    errno = -bytes;
+    throw socketError("Unable to receive data");
+}
+
+Task<void> AsyncSocket::write(std::string_view data)
+{
+    ssize_t written = co_await loop->send(fd, std::span(&data, 1));
+    if (written < 0) {
+        errno = -written;
+        throw socketError("Unable to send data");
+    }
+}
+
+Task<void> AsyncSocket::write(std::initializer_list<std::string_view> parts)
+{
+    // The list's backing array only lives until the end of the full-expression
+    // that created it, so keep a copy in the coroutine frame
+    std::vector<std::string_view> chunks(parts);
+
+    ssize_t written = co_await loop->send(fd, chunks);
+    if (written < 0) {
+        errno = -written;
+        throw socketError("Unable to send data");
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "EventLoop.hpp"
+#include "Task.hpp"
+#include <sys/socket.h>
+
+#include <initializer_list>
+#include <span>
+#include <string>
+#include <string_view>
+
+// Socket whose operations are awaited from coroutines:
+//
+//     size_t read = co_await socket.read(buffer);
+//     co_await socket.write(response);
+//
+// The calling coroutine is suspended until the operation completes and is
+// resumed by the EventLoop, so one thread can drive many connections.
+class AsyncSocket
+{
+  private:
+    EventLoop *loop;
+    int fd;
+
+  public:
+    AsyncSocket(EventLoop &loop, int fd);
+    AsyncSocket(AsyncSocket &&socket) noexcept;
+    AsyncSocket &operator=(AsyncSocket &&socket) noexcept;
+    AsyncSocket(const AsyncSocket &) = delete;
+    AsyncSocket &operator=(const AsyncSocket &) = delete;
+    ~AsyncSocket();
+
+    static AsyncSocket listen(EventLoop &loop, const std::string &port, int backlog = SOMAXCONN);
+    static Task<AsyncSocket> connect(EventLoop &loop, const char *hostname, std::string service = "http");
+
+    Task<AsyncSocket> accept();
+
+    // Reads whatever is available (at least one byte); 0 means the peer closed
+    Task<size_t> read(std::span<char> buffer);
+    // Writes the whole buffer
+    Task<void> write(std::string_view data);
+    // Writes the parts one after another without joining them first
+    Task<void> write(std::initializer_list<std::string_view> parts);
+
+    int socket() const;
+    void close();
+};
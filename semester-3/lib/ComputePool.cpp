@@ -0,0 +1,61 @@
+#include "ComputePool.hpp"
+#include <algorithm>
+
+ComputePool::ComputePool(size_t threads, size_t capacity) : capacity(capacity)
+{
+    threads = std::max<size_t>(threads, 1);
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back(&ComputePool::run, this);
+    }
+}
+
+ComputePool::~ComputePool()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopped = true;
+    }
+    available.notify_all();
+
+    for (auto &&worker : workers) {
+        worker.join();
+    }
+}
+
+void ComputePool::run()
+{
+    while (true) {
+        Job job;
+        {
+            std::unique_lock lock(mutex);
+            available.wait(lock, [this] { return stopped || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        job();
+    }
+}
+
+bool ComputePool::trySubmit(Job job)
+{
+    {
+        std::lock_guard lock(mutex);
+        if (stopped || queue.size() >= capacity) {
+            return false;
+        }
+        queue.push_back(std::move(job));
+    }
+    available.notify_one();
+    return true;
+}
+
+size_t ComputePool::queued()
+{
+    std::lock_guard lock(mutex);
+    return queue.size();
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads for CPU-bound work, kept apart from the
+// threads doing I/O. The queue is bounded: once it is full, submitting
+// fails right away instead of blocking, so a server can turn work away
+// while it still answers quickly.
+class ComputePool
+{
+  public:
+    using Job = std::function<void()>;
+
+  private:
+    const size_t capacity;
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<Job> queue;
+    bool stopped = false;
+    std::vector<std::thread> workers;
+
+    void run();
+
+  public:
+    ComputePool(size_t threads = std::thread::hardware_concurrency(), size_t capacity = 64);
+    ComputePool(const ComputePool &) = delete;
+    ComputePool &operator=(const ComputePool &) = delete;
+    // Finishes the queued jobs, then joins the workers
+    ~ComputePool();
+
+    // Returns false if the queue is full
+    bool trySubmit(Job job);
+
+    // Returns the future result of `function`, or nothing if the queue is
+    // full. Exceptions thrown by `function` come out of the future.
+    template <class F>
+    std::optional<std::future<std::invoke_result_t<F &>>> trySubmit(F function)
+    {
+        using Result = std::invoke_result_t<F &>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::move(function));
+        std::future<Result> result = task->get_future();
+
+        if (!trySubmit(Job([task] { (*task)(); }))) {
+            return std::nullopt;
+        }
+        return result;
+    }
+
+    size_t queued();
+};
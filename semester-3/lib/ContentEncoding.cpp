@@ -0,0 +1,260 @@
+#include "ContentEncoding.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+static std::string toLower(std::string string)
+{
+    std::transform(string.begin(), string.end(), string.begin(), ::tolower);
+    return string;
+}
+
+static std::string trim(const std::string &string)
+{
+    size_t begin = string.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    return string.substr(begin, string.find_last_not_of(" \t") - begin + 1);
+}
+
+static const std::string *findHeader(const std::map<std::string, std::string> &headers, const std::string &name)
+{
+    for (auto &&header : headers) {
+        if (toLower(header.first) == name) {
+            return &header.second;
+        }
+    }
+    return nullptr;
+}
+
+static bool isCompressible(const std::string &contentType)
+{
+    static const std::string COMPRESSIBLE_TYPES[] = {
+        "application/javascript",
+        "application/json",
+        "application/xml",
+        "image/svg+xml",
+    };
+
+    std::string type = toLower(trim(contentType.substr(0, contentType.find(';'))));
+    return type.starts_with("text/") ||
+           std::find(std::begin(COMPRESSIBLE_TYPES), std::end(COMPRESSIBLE_TYPES), type) != std::end(COMPRESSIBLE_TYPES);
+}
+
+ContentEncoding negotiateEncoding(const std::string &acceptEncoding,
+                                  const std::map<std::string, std::string> &responseHeaders,
+                                  const CompressionOptions &options)
+{
+    if (!options.enabled || acceptEncoding.empty() || findHeader(responseHeaders, "content-encoding")) {
+        return ContentEncoding::Identity;
+    }
+
+    const std::string *contentType = findHeader(responseHeaders, "content-type");
+    if (!contentType || !isCompressible(*contentType)) {
+        return ContentEncoding::Identity;
+    }
+    const std::string *contentLength = findHeader(responseHeaders, "content-length");
+    if (contentLength && std::strtoull(contentLength->c_str(), nullptr, 10) < options.minSize) {
+        return ContentEncoding::Identity;
+    }
+
+    // "gzip;q=1.0, deflate;q=0.5, *;q=0"
+    double gzip = -1, deflate = -1, any = -1;
+    size_t start = 0;
+    while (start <= acceptEncoding.size()) {
+        size_t end = std::min(acceptEncoding.find(',', start), acceptEncoding.size());
+        std::string item = acceptEncoding.substr(start, end - start);
+        start = end + 1;
+
+        size_t semicolon = item.find(';');
+        std::string coding = toLower(trim(item.substr(0, semicolon)));
+        double quality = 1;
+        if (semicolon != std::string::npos) {
+            std::string parameter = trim(item.substr(semicolon + 1));
+            if (parameter.starts_with("q=")) {
+                quality = std::strtod(parameter.c_str() + 2, nullptr);
+            }
+        }
+
+        if (coding == "gzip" || coding == "x-gzip") {
+            gzip = quality;
+        } else if (coding == "deflate") {
+            deflate = quality;
+        } else if (coding == "*") {
+            any = quality;
+        }
+    }
+    if (gzip < 0) gzip = any;
+    if (deflate < 0) deflate = any;
+
+    // Some clients mishandle raw vs. zlib-wrapped deflate, so gzip wins ties
+    if (gzip > 0 && gzip >= deflate) {
+        return ContentEncoding::Gzip;
+    }
+    if (deflate > 0) {
+        return ContentEncoding::Deflate;
+    }
+    return ContentEncoding::Identity;
+}
+
+const char *encodingName(ContentEncoding encoding)
+{
+    switch (encoding) {
+        case ContentEncoding::Gzip:
+            return "gzip";
+        case ContentEncoding::Deflate:
+            return "deflate";
+        default:
+            return "identity";
+    }
+}
+
+DeflateStreamBuffer::DeflateStreamBuffer(std::streambuf *sink, ContentEncoding encoding, int level) : sink(sink)
+{
+    // 16 added to the window size selects the gzip wrapper instead of zlib's
+    int windowBits = encoding == ContentEncoding::Gzip ? 15 + 16 : 15;
+    if (deflateInit2(&zs, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("Unable to initialize zlib");
+    }
+    setp(input, input + sizeof(input));
+}
+
+DeflateStreamBuffer::~DeflateStreamBuffer()
+{
+    deflateEnd(&zs);
+}
+
+bool DeflateStreamBuffer::deflate(const char *data, size_t size, int flush)
+{
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    zs.avail_in = size;
+
+    // Until zlib stops filling the whole output buffer
+    do {
+        zs.next_out = reinterpret_cast<Bytef *>(output);
+        zs.avail_out = sizeof(output);
+        ::deflate(&zs, flush);
+
+        std::streamsize produced = sizeof(output) - zs.avail_out;
+        if (produced && sink->sputn(output, produced) != produced) {
+            return false;
+        }
+    } while (!zs.avail_out);
+
+    return true;
+}
+
+std::streambuf::int_type DeflateStreamBuffer::overflow(std::streambuf::int_type value)
+{
+    if (finished || !deflate(pbase(), pptr() - pbase(), Z_NO_FLUSH)) {
+        return traits_type::eof();
+    }
+    setp(input, input + sizeof(input));
+
+    if (!traits_type::eq_int_type(value, traits_type::eof())) {
+        sputc(value);
+    }
+    return traits_type::not_eof(value);
+}
+
+std::streamsize DeflateStreamBuffer::xsputn(const char *data, std::streamsize count)
+{
+    // Big writes go to zlib directly rather than through the input buffer
+    if (static_cast<size_t>(count) < sizeof(input) / 4) {
+        return std::streambuf::xsputn(data, count);
+    }
+
+    if (finished || !deflate(pbase(), pptr() - pbase(), Z_NO_FLUSH)) {
+        return 0;
+    }
+    setp(input, input + sizeof(input));
+    return deflate(data, count, Z_NO_FLUSH) ? count : 0;
+}
+
+int DeflateStreamBuffer::sync()
+{
+    if (finished || !deflate(pbase(), pptr() - pbase(), Z_SYNC_FLUSH)) {
+        return -1;
+    }
+    setp(input, input + sizeof(input));
+    return sink->pubsync();
+}
+
+bool DeflateStreamBuffer::finish()
+{
+    if (finished) {
+        return true;
+    }
+    finished = true;
+
+    bool written = deflate(pbase(), pptr() - pbase(), Z_FINISH);
+    setp(input, input + sizeof(input));
+    return written;
+}
+
+ChunkedStreamBuffer::ChunkedStreamBuffer(std::streambuf *sink) : sink(sink)
+{
+    setp(buffer, buffer + sizeof(buffer));
+}
+
+bool ChunkedStreamBuffer::writeChunk(const char *data, size_t size)
+{
+    if (!size) {
+        return true;
+    }
+
+    char head[24];
+    int headSize = std::snprintf(head, sizeof(head), "%zx\r\n", size);
+    return sink->sputn(head, headSize) == headSize &&
+           sink->sputn(data, size) == static_cast<std::streamsize>(size) && sink->sputn("\r\n", 2) == 2;
+}
+
+std::streambuf::int_type ChunkedStreamBuffer::overflow(std::streambuf::int_type value)
+{
+    if (finished || !writeChunk(pbase(), pptr() - pbase())) {
+        return traits_type::eof();
+    }
+    setp(buffer, buffer + sizeof(buffer));
+
+    if (!traits_type::eq_int_type(value, traits_type::eof())) {
+        sputc(value);
+    }
+    return traits_type::not_eof(value);
+}
+
+std::streamsize ChunkedStreamBuffer::xsputn(const char *data, std::streamsize count)
+{
+    // Big writes become chunks of their own instead of being copied
+    if (static_cast<size_t>(count) < sizeof(buffer) / 4) {
+        return std::streambuf::xsputn(data, count);
+    }
+
+    if (finished || !writeChunk(pbase(), pptr() - pbase())) {
+        return 0;
+    }
+    setp(buffer, buffer + sizeof(buffer));
+    return writeChunk(data, count) ? count : 0;
+}
+
+int ChunkedStreamBuffer::sync()
+{
+    if (finished || !writeChunk(pbase(), pptr() - pbase())) {
+        return -1;
+    }
+    setp(buffer, buffer + sizeof(buffer));
+    return sink->pubsync();
+}
+
+bool ChunkedStreamBuffer::finish()
+{
+    if (finished) {
+        return true;
+    }
+    finished = true;
+
+    bool written = writeChunk(pbase(), pptr() - pbase()) && sink->sputn("0\r\n\r\n", 5) == 5;
+    setp(buffer, buffer + sizeof(buffer));
+    return written;
+}
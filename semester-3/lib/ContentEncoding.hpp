@@ -0,0 +1,79 @@
+#pragma once
+#include <zlib.h>
+
+#include <map>
+#include <streambuf>
+#include <string>
+
+enum class ContentEncoding {
+    Identity,
+    Gzip,
+    Deflate,
+};
+
+struct CompressionOptions {
+    bool enabled = true;
+    // Below this, headers and framing eat most of the savings
+    size_t minSize = 1024;
+    // zlib level: 1 is fastest, 9 is smallest
+    int level = 6;
+};
+
+// Picks an encoding for a response given the request's Accept-Encoding and
+// the response headers. Only text-like content types are compressed; images,
+// archives and anything already encoded go out as they are.
+ContentEncoding negotiateEncoding(const std::string &acceptEncoding,
+                                  const std::map<std::string, std::string> &responseHeaders,
+                                  const CompressionOptions &options);
+const char *encodingName(ContentEncoding encoding);
+
+// Output-only streambuf that compresses everything written to it and passes
+// the result on to `sink`. finish() must be called after the last write.
+class DeflateStreamBuffer : public std::streambuf
+{
+  private:
+    std::streambuf *sink;
+    z_stream zs {};
+    char input[16 * 1024];
+    char output[16 * 1024];
+    bool finished = false;
+
+    bool deflate(const char *data, size_t size, int flush);
+
+  public:
+    DeflateStreamBuffer(std::streambuf *sink, ContentEncoding encoding, int level = Z_DEFAULT_COMPRESSION);
+    DeflateStreamBuffer(const DeflateStreamBuffer &) = delete;
+    DeflateStreamBuffer &operator=(const DeflateStreamBuffer &) = delete;
+    ~DeflateStreamBuffer();
+
+    virtual std::streambuf::int_type overflow(std::streambuf::int_type value) override;
+    virtual std::streamsize xsputn(const char *data, std::streamsize count) override;
+    // Flushes what has been compressed so far (Z_SYNC_FLUSH), costing a few
+    // bytes of ratio; meant for streamed responses
+    virtual int sync() override;
+
+    bool finish();
+};
+
+// Output-only streambuf that frames writes as HTTP/1.1 chunks, for bodies
+// whose length isn't known up front. finish() writes the final chunk.
+class ChunkedStreamBuffer : public std::streambuf
+{
+  private:
+    std::streambuf *sink;
+    char buffer[16 * 1024];
+    bool finished = false;
+
+    bool writeChunk(const char *data, size_t size);
+
+  public:
+    ChunkedStreamBuffer(std::streambuf *sink);
+    ChunkedStreamBuffer(const ChunkedStreamBuffer &) = delete;
+    ChunkedStreamBuffer &operator=(const ChunkedStreamBuffer &) = delete;
+
+    virtual std::streambuf::int_type overflow(std::streambuf::int_type value) override;
+    virtual std::streamsize xsputn(const char *data, std::streamsize count) override;
+    virtual int sync() override;
+
+    bool finish();
+};
@@ -0,0 +1,197 @@
+#include "EpollEventLoop.hpp"
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+constexpr int MAX_EVENTS = 256;
+
+EpollEventLoop::EpollEventLoop() : epollFd(epoll_create1(EPOLL_CLOEXEC))
+{
+    if (epollFd < 0) {
+        throw std::runtime_error(std::string("Unable to create epoll instance: \"") + std::strerror(errno) + '"');
+    }
+}
+
+EpollEventLoop::~EpollEventLoop()
+{
+    close(epollFd);
+}
+
+const char *EpollEventLoop::name() const
+{
+    return "epoll";
+}
+
+void EpollEventLoop::add(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    epoll_event event {};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.fd = fd;
+
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        throw std::runtime_error(std::string("Unable to watch socket: \"") + std::strerror(errno) + '"');
+    }
+    waiters[fd] = {};
+}
+
+void EpollEventLoop::remove(int fd)
+{
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    waiters.erase(fd);
+}
+
+EpollEventLoop::Readiness::Readiness(EpollEventLoop &loop, int fd, bool write) : loop(loop), fd(fd), write(write)
+{
+}
+
+void EpollEventLoop::Readiness::await_suspend(std::coroutine_handle<> handle)
+{
+    Waiters &waiting = loop.waiters[fd];
+    (write ? waiting.writer : waiting.reader) = handle;
+}
+
+EpollEventLoop::Readiness EpollEventLoop::readable(int fd)
+{
+    return Readiness(*this, fd, false);
+}
+
+EpollEventLoop::Readiness EpollEventLoop::writable(int fd)
+{
+    return Readiness(*this, fd, true);
+}
+
+Task<int> EpollEventLoop::accept(int fd)
+{
+    while (true) {
+        int client = accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client >= 0) {
+            co_return client;
+        }
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            co_await readable(fd);
+        } else if (errno != EINTR && errno != ECONNABORTED) {
+            co_return -errno;
+        }
+    }
+}
+
+Task<int> EpollEventLoop::connect(int fd, const sockaddr *address, socklen_t length)
+{
+    if (::connect(fd, address, length) == 0) {
+        co_return 0;
+    }
+    if (errno != EINPROGRESS) {
+        co_return -errno;
+    }
+
+    co_await writable(fd);
+
+    int error = 0;
+    socklen_t errorLength = sizeof(error);
+    getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &errorLength);
+    co_return -error;
+}
+
+Task<ssize_t> EpollEventLoop::recv(int fd, std::span<char> buffer)
+{
+    while (true) {
+        ssize_t bytes = ::recv(fd, buffer.data(), buffer.size(), 0);
+        if (bytes >= 0) {
+            co_return bytes;
+        }
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            co_await readable(fd);
+        } else if (errno != EINTR) {
+            co_return -errno;
+        }
+    }
+}
+
+Task<ssize_t> EpollEventLoop::send(int fd, std::span<const std::string_view> parts)
+{
+    std::vector<iovec> iov;
+    iov.reserve(parts.size());
+    for (auto &&part : parts) {
+        if (!part.empty()) iov.push_back({const_cast<char *>(part.data()), part.size()});
+    }
+
+    ssize_t total = 0;
+    size_t first = 0;
+    while (first < iov.size()) {
+        msghdr message {};
+        message.msg_iov = iov.data() + first;
+        message.msg_iovlen = std::min<size_t>(iov.size() - first, IOV_MAX);
+
+        ssize_t written = sendmsg(fd, &message, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                co_await writable(fd);
+                continue;
+            }
+            if (errno == EINTR) continue;
+            co_return -errno;
+        }
+
+        total += written;
+        while (first < iov.size() && static_cast<size_t>(written) >= iov[first].iov_len) {
+            written -= iov[first++].iov_len;
+        }
+        if (first < iov.size()) {
+            iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + written;
+            iov[first].iov_len -= written;
+        }
+    }
+    co_return total;
+}
+
+void EpollEventLoop::run()
+{
+    epoll_event events[MAX_EVENTS];
+
+    while (!stopped) {
+        int count = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("epoll_wait() call failed: \"") + std::strerror(errno) + '"');
+        }
+
+        for (int i = 0; i < count; i++) {
+            // Resuming a coroutine may close descriptors, so look them up anew
+            auto it = waiters.find(events[i].data.fd);
+            if (it == waiters.end()) continue;
+
+            uint32_t flags = events[i].events;
+            bool failed = flags & (EPOLLERR | EPOLLHUP);
+
+            std::coroutine_handle<> reader, writer;
+            if (it->second.reader && (flags & (EPOLLIN | EPOLLRDHUP) || failed)) {
+                reader = std::exchange(it->second.reader, nullptr);
+            }
+            if (it->second.writer && (flags & EPOLLOUT || failed)) {
+                writer = std::exchange(it->second.writer, nullptr);
+            }
+
+            if (reader) reader.resume();
+            if (writer && waiters.count(events[i].data.fd)) writer.resume();
+        }
+    }
+}
+
+void EpollEventLoop::stop()
+{
+    stopped = true;
+}
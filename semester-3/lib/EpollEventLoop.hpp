@@ -0,0 +1,61 @@
+#pragma once
+#include "EventLoop.hpp"
+#include <sys/epoll.h>
+
+#include <coroutine>
+#include <unordered_map>
+
+// Edge-triggered epoll reactor: operations are attempted right away and the
+// coroutine is suspended until the descriptor becomes ready on EAGAIN.
+class EpollEventLoop : public EventLoop
+{
+  private:
+    struct Waiters {
+        std::coroutine_handle<> reader;
+        std::coroutine_handle<> writer;
+    };
+
+    int epollFd;
+    bool stopped = false;
+    std::unordered_map<int, Waiters> waiters;
+
+    class Readiness
+    {
+      private:
+        EpollEventLoop &loop;
+        int fd;
+        bool write;
+
+      public:
+        Readiness(EpollEventLoop &loop, int fd, bool write);
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+    Readiness readable(int fd);
+    Readiness writable(int fd);
+
+  public:
+    EpollEventLoop();
+    virtual ~EpollEventLoop();
+
+    virtual const char *name() const override;
+
+    virtual void add(int fd) override;
+    virtual void remove(int fd) override;
+
+    virtual Task<int> accept(int fd) override;
+    virtual Task<int> connect(int fd, const sockaddr *address, socklen_t length) override;
+    virtual Task<ssize_t> recv(int fd, std::span<char> buffer) override;
+    virtual Task<ssize_t> send(int fd, std::span<const std::string_view> parts) override;
+
+    virtual void run() override;
+    virtual void stop() override;
+};
@@ -0,0 +1,34 @@
+#include "EventLoop.hpp"
+#include "EpollEventLoop.hpp"
+#include "IoUringEventLoop.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+IoBackend parseIoBackend(std::string_view name)
+{
+    if (name == "auto") return IoBackend::Auto;
+    if (name == "epoll") return IoBackend::Epoll;
+    if (name == "io_uring") return IoBackend::IoUring;
+    throw std::invalid_argument("Unknown I/O backend \"" + std::string(name) + '"');
+}
+
+std::unique_ptr<EventLoop> EventLoop::create(IoBackend backend)
+{
+    switch (backend) {
+        case IoBackend::Epoll:
+            return std::unique_ptr<EventLoop>(new EpollEventLoop());
+        case IoBackend::IoUring:
+            return std::unique_ptr<EventLoop>(new IoUringEventLoop());
+        case IoBackend::Auto:
+            break;
+    }
+
+    try {
+        return std::unique_ptr<EventLoop>(new IoUringEventLoop());
+    } catch (const std::runtime_error &e) {
+        std::cerr << e.what() << ", falling back to epoll" << std::endl;
+        return std::unique_ptr<EventLoop>(new EpollEventLoop());
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "Task.hpp"
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <string_view>
+
+enum class IoBackend {
+    Auto,
+    Epoll,
+    IoUring,
+};
+
+// Accepts "auto", "epoll" and "io_uring"
+IoBackend parseIoBackend(std::string_view name);
+
+// Single-threaded I/O driver for coroutines. Socket operations are awaited
+// and their results follow the syscall convention: a non-negative value on
+// success, -errno on failure.
+//
+// Two implementations exist: EpollEventLoop (readiness based) and
+// IoUringEventLoop (completion based); create() picks one at startup.
+class EventLoop
+{
+  public:
+    EventLoop() = default;
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+    virtual ~EventLoop() = default;
+
+    // Auto prefers io_uring and falls back to epoll when the kernel (or a
+    // seccomp policy) doesn't allow it
+    static std::unique_ptr<EventLoop> create(IoBackend backend = IoBackend::Auto);
+
+    virtual const char *name() const = 0;
+
+    // Registers a socket with the loop; remove() must be called before it
+    // is closed
+    virtual void add(int fd) = 0;
+    virtual void remove(int fd) = 0;
+
+    virtual Task<int> accept(int fd) = 0;
+    virtual Task<int> connect(int fd, const sockaddr *address, socklen_t length) = 0;
+    // Receives at least one byte; 0 means the peer closed the connection
+    virtual Task<ssize_t> recv(int fd, std::span<char> buffer) = 0;
+    // Sends every part, in order; returns the total byte count
+    virtual Task<ssize_t> send(int fd, std::span<const std::string_view> parts) = 0;
+
+    virtual void run() = 0;
+    virtual void stop() = 0;
+};
@@ -0,0 +1,356 @@
+#include "HttpClient.hpp"
+#include <poll.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+constexpr size_t BODY_CHUNK_SIZE = 16 * 1024;
+
+static std::string toLower(std::string string)
+{
+    std::transform(string.begin(), string.end(), string.begin(), ::tolower);
+    return string;
+}
+
+static bool hasHeader(const Request &request, const std::string &name)
+{
+    return std::any_of(request.headers.begin(), request.headers.end(), [&](auto &&header) {
+        return toLower(header.first) == name;
+    });
+}
+
+static void writeRequest(std::ostream &stream, const std::string &host, const Request &request)
+{
+    stream << request.method << ' ' << request.path << " HTTP/1.1" << net::endl;
+    if (!hasHeader(request, "host")) {
+        stream << "Host: " << host << net::endl;
+    }
+    if (!request.body.empty() && !hasHeader(request, "content-length")) {
+        stream << "Content-Length: " << request.body.size() << net::endl;
+    }
+    for (auto &&header : request.headers) {
+        stream << header.first << ": " << header.second << net::endl;
+    }
+    stream << net::endl;
+    stream.write(request.body.data(), request.body.size());
+}
+
+static bool readLine(std::istream &stream, std::string &line)
+{
+    if (!std::getline(stream, line)) {
+        return false;
+    }
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    return true;
+}
+
+// Returns false if the connection was closed before anything arrived
+static bool readResponseHead(std::istream &stream, ClientResponse &response)
+{
+    std::string line;
+    do {
+        response = {};
+        if (!readLine(stream, line)) {
+            return false;
+        }
+
+        // "HTTP/1.1 200 OK"
+        size_t space = line.find(' ');
+        if (line.compare(0, 5, "HTTP/") || space == std::string::npos || line.size() < space + 4) {
+            throw std::runtime_error("Malformed status line: \"" + line + '"');
+        }
+        response.status = std::atoi(line.c_str() + space + 1);
+        response.message = line.size() > space + 5 ? line.substr(space + 5) : "";
+
+        while (true) {
+            if (!readLine(stream, line)) {
+                throw std::runtime_error("Connection closed in the middle of a response");
+            }
+            if (line.empty()) {
+                break;
+            }
+
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) {
+                throw std::runtime_error("Malformed header: \"" + line + '"');
+            }
+            std::string name = toLower(line.substr(0, colon));
+            std::string value = line.substr(std::min(line.find_first_not_of(' ', colon + 1), line.size()));
+
+            auto &&it = response.headers.find(name);
+            if (it != response.headers.end()) {
+                it->second += ", " + value;
+            } else {
+                response.headers[name] = value;
+            }
+        }
+        // Interim responses (100 Continue) precede the real one
+    } while (response.status >= 100 && response.status < 200 && response.status != 101);
+
+    return true;
+}
+
+BodyDecoder::BodyDecoder(const ClientResponse &head, const std::string &method)
+{
+    auto &&connection = head.headers.find("connection");
+    closeAfter = connection != head.headers.end() && toLower(connection->second).find("close") != std::string::npos;
+
+    auto &&transferEncoding = head.headers.find("transfer-encoding");
+    auto &&contentLength = head.headers.find("content-length");
+    bool chunked = transferEncoding != head.headers.end() &&
+                   toLower(transferEncoding->second).find("chunked") != std::string::npos;
+
+    if (method == "HEAD" || head.status == 204 || head.status == 304) {
+        finished = true;
+    } else if (chunked) {
+        framing = Framing::Chunked;
+    } else if (contentLength != head.headers.end()) {
+        remaining = std::stoul(contentLength->second);
+        finished = !remaining;
+    } else {
+        framing = Framing::UntilClose;
+    }
+}
+
+bool BodyDecoder::nextChunk(std::istream &stream)
+{
+    std::string line;
+    if (!readLine(stream, line)) {
+        throw std::runtime_error("Connection closed in the middle of a response");
+    }
+    // Chunk extensions after ';' carry nothing we use
+    remaining = std::stoul(line.substr(0, line.find(';')), nullptr, 16);
+    if (remaining) {
+        return true;
+    }
+
+    // Skip trailers up to the final empty line
+    while (readLine(stream, line) && !line.empty()) {
+    }
+    return false;
+}
+
+size_t BodyDecoder::read(std::istream &stream, std::span<char> buffer)
+{
+    if (finished || buffer.empty()) {
+        return 0;
+    }
+    if (framing == Framing::Chunked && !remaining && !nextChunk(stream)) {
+        finished = true;
+        return 0;
+    }
+
+    size_t wanted = framing == Framing::UntilClose ? buffer.size() : std::min(buffer.size(), remaining);
+    size_t got = stream.rdbuf()->sgetn(buffer.data(), wanted);
+
+    if (framing == Framing::UntilClose) {
+        finished = !got;
+        return got;
+    }
+    if (got < wanted) {
+        throw std::runtime_error("Connection closed in the middle of a response");
+    }
+
+    remaining -= got;
+    if (!remaining) {
+        if (framing == Framing::Length) {
+            finished = true;
+        } else {
+            std::string line;
+            readLine(stream, line);
+        }
+    }
+    return got;
+}
+
+bool BodyDecoder::done() const
+{
+    return finished;
+}
+
+bool BodyDecoder::reusable() const
+{
+    return finished && framing != Framing::UntilClose && !closeAfter;
+}
+
+static void readBody(std::istream &stream, BodyDecoder &decoder, std::string &body)
+{
+    while (!decoder.done()) {
+        size_t size = body.size();
+        body.resize(size + BODY_CHUNK_SIZE);
+        body.resize(size + decoder.read(stream, std::span(body).subspan(size)));
+    }
+}
+
+ResponseReader::ResponseReader(HttpClient &client, std::string poolKey, std::unique_ptr<NetworkStream> connection,
+                               ClientResponse &&head, const BodyDecoder &body)
+    : client(&client), poolKey(std::move(poolKey)), connection(std::move(connection)), response(std::move(head)),
+      body(body)
+{
+}
+
+ResponseReader::~ResponseReader()
+{
+    if (connection && body.reusable()) {
+        client->release(poolKey, std::move(connection));
+    }
+}
+
+const ClientResponse &ResponseReader::head() const
+{
+    return response;
+}
+
+size_t ResponseReader::read(std::span<char> buffer)
+{
+    return body.read(*connection, buffer);
+}
+
+std::string ResponseReader::readAll()
+{
+    std::string result;
+    readBody(*connection, body, result);
+    return result;
+}
+
+HttpClient::HttpClient(const HttpClientOptions &options) : options(options), addresses(options.dnsTtl)
+{
+}
+
+// An idle keep-alive connection that became readable was closed (or
+// broken) by the server
+static bool stillOpen(NetworkStream &stream)
+{
+    pollfd fd = {stream.socket(), POLLIN, 0};
+    return poll(&fd, 1, 0) == 0;
+}
+
+std::unique_ptr<NetworkStream> HttpClient::acquire(const std::string &host, const std::string &port, bool &reused)
+{
+    {
+        std::lock_guard lock(mutex);
+        auto &&idle = pool[host + ':' + port];
+        while (!idle.empty()) {
+            IdleConnection connection = std::move(idle.back());
+            idle.pop_back();
+
+            if (Clock::now() - connection.since < options.idleTimeout && stillOpen(*connection.stream)) {
+                reused = true;
+                return std::move(connection.stream);
+            }
+        }
+    }
+
+    reused = false;
+    std::shared_ptr<const AddrInfo> addrInfo = addresses.resolve(host, port);
+    try {
+        return std::unique_ptr<NetworkStream>(new NetworkStream(*addrInfo));
+    } catch (const std::runtime_error &e) {
+        // The cached address may be the reason
+        addresses.forget(host, port);
+        throw;
+    }
+}
+
+void HttpClient::release(const std::string &poolKey, std::unique_ptr<NetworkStream> connection)
+{
+    std::lock_guard lock(mutex);
+    auto &&idle = pool[poolKey];
+    if (idle.size() < options.maxIdlePerHost) {
+        idle.push_back({std::move(connection), Clock::now()});
+    }
+}
+
+// Requests that may be sent twice: a request on a connection that broke
+// without a response may still have reached the server
+static bool isIdempotent(const std::string &method)
+{
+    return method == "GET" || method == "HEAD" || method == "PUT" || method == "DELETE" || method == "OPTIONS";
+}
+
+ResponseReader HttpClient::send(const std::string &host, const std::string &port, const Request &request)
+{
+    for (bool retried = false;; retried = true) {
+        bool reused;
+        std::unique_ptr<NetworkStream> connection = acquire(host, port, reused);
+
+        writeRequest(*connection, host, request);
+        connection->flush();
+
+        ClientResponse head;
+        if (*connection && readResponseHead(*connection, head)) {
+            BodyDecoder body(head, request.method);
+            return ResponseReader(*this, host + ':' + port, std::move(connection), std::move(head), body);
+        }
+
+        // The server may have dropped a pooled connection just as we picked
+        // it up; nothing was received, so the request is sent again if that
+        // is harmless
+        if (!reused || retried || !isIdempotent(request.method)) {
+            throw std::runtime_error("Connection closed before a response arrived");
+        }
+    }
+}
+
+ClientResponse HttpClient::request(const std::string &host, const std::string &port, const Request &request)
+{
+    ResponseReader reader = send(host, port, request);
+    ClientResponse response = reader.head();
+    response.body = reader.readAll();
+    return response;
+}
+
+std::vector<ClientResponse> HttpClient::pipeline(const std::string &host, const std::string &port,
+                                                 const std::vector<Request> &requests)
+{
+    std::vector<ClientResponse> responses;
+    bool retried = false;
+
+    while (responses.size() < requests.size()) {
+        bool reused;
+        std::unique_ptr<NetworkStream> connection = acquire(host, port, reused);
+
+        size_t first = responses.size();
+        for (size_t i = first; i < requests.size(); i++) {
+            writeRequest(*connection, host, requests[i]);
+        }
+        connection->flush();
+
+        bool reusable = true;
+        while (reusable && responses.size() < requests.size()) {
+            ClientResponse response;
+            if (!*connection || !readResponseHead(*connection, response)) {
+                bool repeatable = std::all_of(requests.begin() + responses.size(), requests.end(), [](const Request &request) {
+                    return isIdempotent(request.method);
+                });
+                if (!repeatable) {
+                    throw std::runtime_error("Connection closed before a response arrived");
+                }
+                if (responses.size() == first) {
+                    if (!reused || retried) {
+                        throw std::runtime_error("Connection closed before a response arrived");
+                    }
+                    retried = true;
+                }
+                // Send whatever is left again, all of it safe to repeat
+                reusable = false;
+                break;
+            }
+
+            BodyDecoder body(response, requests[responses.size()].method);
+            readBody(*connection, body, response.body);
+            responses.push_back(std::move(response));
+
+            // After `Connection: close` the rest of the pipeline was discarded
+            reusable = body.reusable();
+        }
+
+        if (reusable) {
+            release(host + ':' + port, std::move(connection));
+        }
+    }
+    return responses;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include "AddrInfo.hpp"
+#include "HttpServer.hpp"
+#include "NetworkStream.hpp"
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+class HttpClient;
+
+struct ClientResponse {
+    int status = 0;
+    std::string message;
+    // Header names are lower-cased
+    std::map<std::string, std::string> headers;
+    std::string body;
+};
+
+// Decodes a response body (Content-Length, chunked or until-close) from a
+// stream, in pieces of whatever size the caller asks for
+class BodyDecoder
+{
+  private:
+    enum class Framing { Length, Chunked, UntilClose };
+
+    Framing framing = Framing::Length;
+    size_t remaining = 0;
+    bool finished = false;
+    bool closeAfter = false;
+
+    bool nextChunk(std::istream &stream);
+
+  public:
+    BodyDecoder() = default;
+    BodyDecoder(const ClientResponse &head, const std::string &method);
+
+    // Returns 0 once the body is over; throws if the stream breaks first
+    size_t read(std::istream &stream, std::span<char> buffer);
+    bool done() const;
+    // Whether the connection can carry another response afterwards
+    bool reusable() const;
+};
+
+// Response whose body is read on demand, straight into caller buffers:
+//
+//     ResponseReader reader = client.send("localhost", "80", request);
+//     while (size_t read = reader.read(buffer)) ...
+//
+// Once the body has been read, the connection goes back to the pool.
+// A reader dropped halfway through the body closes the connection.
+class ResponseReader
+{
+  private:
+    HttpClient *client;
+    std::string poolKey;
+    std::unique_ptr<NetworkStream> connection;
+    ClientResponse response;
+    BodyDecoder body;
+
+  public:
+    ResponseReader(HttpClient &client, std::string poolKey, std::unique_ptr<NetworkStream> connection,
+                   ClientResponse &&head, const BodyDecoder &body);
+    ResponseReader(ResponseReader &&reader) = default;
+    ResponseReader &operator=(ResponseReader &&reader) = delete;
+    ~ResponseReader();
+
+    // Status and headers; the body is not filled in
+    const ClientResponse &head() const;
+    size_t read(std::span<char> buffer);
+    std::string readAll();
+};
+
+struct HttpClientOptions {
+    // Idle connections kept per host:port; the rest are closed
+    size_t maxIdlePerHost = 8;
+    // Pooled connections unused for longer are assumed dropped by the server
+    std::chrono::seconds idleTimeout {30};
+    std::chrono::seconds dnsTtl {60};
+};
+
+// Keep-alive HTTP/1.1 client. Connections are pooled per host and port,
+// and name resolution results are cached, so repeated requests to the same
+// service skip both the lookup and the TCP handshake. Safe to share between
+// threads; each request uses its own connection.
+class HttpClient
+{
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct IdleConnection {
+        std::unique_ptr<NetworkStream> stream;
+        Clock::time_point since;
+    };
+
+    const HttpClientOptions options;
+    AddrInfoCache addresses;
+    std::mutex mutex;
+    std::map<std::string, std::vector<IdleConnection>> pool;
+
+    std::unique_ptr<NetworkStream> acquire(const std::string &host, const std::string &port, bool &reused);
+    void release(const std::string &poolKey, std::unique_ptr<NetworkStream> connection);
+
+    friend class ResponseReader;
+
+  public:
+    HttpClient(const HttpClientOptions &options = {});
+
+    // Sends the request and reads the response head; the body is left for
+    // the returned reader
+    ResponseReader send(const std::string &host, const std::string &port, const Request &request);
+    ClientResponse request(const std::string &host, const std::string &port, const Request &request);
+    // Writes all requests on one connection before reading any response,
+    // saving a round trip per request. Responses come back in order.
+    std::vector<ClientResponse> pipeline(const std::string &host, const std::string &port,
+                                         const std::vector<Request> &requests);
+};
@@ -1,17 +1,26 @@
 #include "HttpServer.hpp"
 #include "AddrInfo.hpp"
+#include "Logging.hpp"
 #include "NetworkStream.hpp"
 #include <arpa/inet.h>
 #include <cerrno>
+#include <csignal>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <netdb.h>
+#include <sstream>
 #include <stdlib.h>
+#include <thread>
 #include <unistd.h>
 
-HttpServer::HttpServer(const std::string &port, RequestHandler handler)
+HttpServer::HttpServer(const std::string &port, RequestHandler handler, const HttpServerOptions &options)
+    : options(options), connectionSlots(options.maxConnections)
 {
+    // sendfile() has no MSG_NOSIGNAL, and a deadline may shut a socket down
+    // in the middle of a response
+    signal(SIGPIPE, SIG_IGN);
+
     const addrinfo hints = {.ai_flags = AI_PASSIVE, .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
     const AddrInfo addrInfo(nullptr, port, hints);
 
@@ -20,7 +29,7 @@ HttpServer::HttpServer(const std::string &port, RequestHandler handler)
         throw std::runtime_error(std::string("Unable to open socket: \"") + std::strerror(errno) + '"');
     }
 
-    int yes = 0;
+    int yes = 1;
     if (setsockopt(masterSocketFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes)) == -1) {
         throw std::runtime_error(std::string("Unable to set socket option: \"") + std::strerror(errno) + '"');
     }
@@ -29,7 +38,7 @@ HttpServer::HttpServer(const std::string &port, RequestHandler handler)
         throw std::runtime_error(std::string("Unable to bind to port: \"") + std::strerror(errno) + '"');
     }
 
-    if (listen(masterSocketFd, 5) < 0) {
+    if (listen(masterSocketFd, options.backlog) < 0) {
         throw std::runtime_error(std::string("listen() call failed: \"") + std::strerror(errno) + '"');
     }
 
@@ -41,35 +50,53 @@ HttpServer::~HttpServer()
     close(masterSocketFd);
 }
 
-void HttpServer::serve(RequestHandler handler) const
+void HttpServer::serve(const RequestHandler &handler)
 {
     while (true) {
+        connectionSlots.acquire();
+
         sockaddr addr;
         socklen_t addrSize = sizeof(addr);
 
         int socketFd = accept(masterSocketFd, reinterpret_cast<sockaddr *>(&addr), &addrSize);
 
         if (socketFd < 0) {
-            std::cout << "> Unable to accept connection: \"" << std::strerror(errno) << '"' << std::endl;
+            HTTP_LOG("> Unable to accept connection: \"" << std::strerror(errno) << '"');
+            connectionSlots.release();
             continue;
         }
+        ServerMetrics::Clock::time_point acceptedAt = ServerMetrics::Clock::now();
 
-        std::cout << "> Accepted connection";
+#if HTTP_LOGGING
         sockaddr peerAddr;
         socklen_t addrlen = sizeof(peerAddr);
 
         if (getpeername(socketFd, &peerAddr, &addrlen) == -1) {
-            std::cout << ", unable to get info about peer (" << std::strerror(errno) << ')' << std::endl;
+            HTTP_LOG("> Accepted connection, unable to get info about peer (" << std::strerror(errno) << ')');
         } else {
             char ip[INET_ADDRSTRLEN];
             inet_ntop(AF_INET, reinterpret_cast<sockaddr_in *>(&peerAddr), ip, INET_ADDRSTRLEN);
-            std::cout << " from " << ip << std::endl;
+            HTTP_LOG("> Accepted connection from " << ip);
         }
+#endif
 
-        NetworkStream stream(socketFd);
-        handle(stream, handler);
-
-        std::cout << "> Closing connection" << std::endl;
+        try {
+            std::thread([this, socketFd, acceptedAt, &handler] {
+                {
+                    ServerMetrics::Recorder metrics(options.metrics);
+                    metrics.start(acceptedAt);
+                    NetworkStream stream(socketFd, options.inputBufferSize, options.outputBufferSize);
+                    metrics.lap(ServerMetrics::Phase::Accept);
+                    handle(stream, handler, metrics);
+                }
+                HTTP_LOG("> Closing connection");
+                connectionSlots.release();
+            }).detach();
+        } catch (const std::system_error &e) {
+            HTTP_LOG("> Unable to start connection thread: \"" << e.what() << '"');
+            close(socketFd);
+            connectionSlots.release();
+        }
     }
 }
 
@@ -81,102 +108,189 @@ static std::istream &ignorews(std::istream &stream)
     return stream;
 }
 
-void HttpServer::handle(NetworkStream &stream, RequestHandler handler) const
+void readRequestHead(std::istream &stream, Request &request)
 {
-    Request request;
+    HTTP_LOG("> Reading method");
+    stream >> request.method;
+
+    if (stream.peek() != ' ') {
+        throw InvalidRequestError();
+    }
+
+    HTTP_LOG("> Reading headers");
+    stream >> request.path;
+    if (stream.peek() == ' ') {
+        std::string httpVersion;
+        stream >> httpVersion;
+        if (httpVersion != "HTTP/1.1") {
+            throw HttpVersionNotSupportedError();
+        }
+    }
+    if (stream.get() != '\r' || stream.get() != '\n') {
+        throw InvalidRequestError();
+    }
+
+    // Headers
     while (true) {
-        try {
-            if (stream.disconnected()) {
-                return;
+        if (stream.peek() == '\r') {
+            stream.get();
+            if (stream.get() == '\n') {
+                break;
             }
 
-            request = {};
+            throw InvalidRequestError();
+        }
 
-            std::cout << "> Reading method" << std::endl;
-            stream >> request.method;
+        std::string headerName {""};
+        char t;
+        for (t = stream.get(); t != ':' && t != '\r' && stream; t = stream.get()) {
+            headerName += tolower(t);
+        }
 
-            if (stream.peek() != ' ') {
-                throw InvalidRequestError();
-            }
+        if (t == '\r') throw InvalidRequestError();
+        if (stream.get() != ' ') throw InvalidRequestError();
 
-            std::cout << "> Reading headers" << std::endl;
-            stream >> request.path;
-            if (stream.peek() == ' ') {
-                std::string httpVersion;
-                stream >> httpVersion;
-                if (httpVersion != "HTTP/1.1") {
-                    throw HttpVersionNotSupportedError();
-                }
+        stream >> ignorews;
+
+        std::string headerValue {""};
+        while (true) {
+            for (char t = stream.get(); t != '\r' && stream; t = stream.get()) {
+                headerValue += t;
             }
-            if (stream.get() != '\r' || stream.get() != '\n') {
+
+            if (stream.get() != '\n') {
                 throw InvalidRequestError();
             }
+            if (stream.peek() != ' ') {
+                break;
+            }
 
-            // Headers
-            while (true) {
-                if (stream.peek() == '\r') {
-                    stream.get();
-                    if (stream.get() == '\n') {
-                        break;
-                    }
+            headerValue += '\n';
+            stream >> ignorews;
+        }
 
-                    throw InvalidRequestError();
-                }
+        auto &&it = request.headers.find(headerName);
+        if (it != request.headers.end()) {
+            it->second += ", ";
+            it->second += headerValue;
+        } else {
+            request.headers[headerName] = headerValue;
+        }
+    }
+}
 
-                std::string headerName {""};
-                char t;
-                for (t = stream.get(); t != ':' && t != '\r'; t = stream.get()) {
-                    headerName += tolower(t);
-                }
+size_t getContentLength(const Request &request)
+{
+    auto &&it = request.headers.find("content-length");
+    if (it == request.headers.end()) {
+        return 0;
+    }
 
-                if (t == '\r') throw InvalidRequestError();
-                if (stream.get() != ' ') throw InvalidRequestError();
+    try {
+        return std::stoul(it->second);
+    } catch (const std::exception &e) {
+        throw BadRequestError();
+    }
+}
 
-                stream >> ignorews;
+// Reads the request line and headers, up to the empty line ending them
+static std::string readHead(std::istream &stream, size_t maxBytes)
+{
+    std::streambuf *buffer = stream.rdbuf();
+    std::string head;
+    while (!head.ends_with("\r\n\r\n")) {
+        if (head.size() >= maxBytes) {
+            throw RequestHeaderFieldsTooLargeError();
+        }
 
-                std::string headerValue {""};
-                while (true) {
-                    for (char t = stream.get(); t != '\r'; t = stream.get()) {
-                        headerValue += t;
-                    }
+        int c = buffer->sbumpc();
+        if (c == std::streambuf::traits_type::eof()) {
+            throw InvalidRequestError();
+        }
+        head += static_cast<char>(c);
+    }
+    return head;
+}
 
-                    if (stream.get() != '\n') {
-                        throw InvalidRequestError();
-                    }
-                    if (stream.peek() != ' ') {
-                        break;
-                    }
+void HttpServer::handle(NetworkStream &stream, const RequestHandler &handler, ServerMetrics::Recorder &metrics)
+{
+    SocketDeadline deadline(timers, stream.socket());
+    // Responses to pipelined requests may still be buffered when the
+    // connection ends, and a client that stops reading mustn't hold on to
+    // the thread; destroyed before the deadline
+    struct FinalFlush {
+        NetworkStream &stream;
+        SocketDeadline &deadline;
+        std::chrono::seconds timeout;
+
+        ~FinalFlush()
+        {
+            deadline.set(timeout);
+            stream.flush();
+        }
+    } finalFlush {stream, deadline, options.writeTimeout};
+    Request request;
+    while (true) {
+        deadline.set(options.idleTimeout);
+        if (stream.peek() == std::istream::traits_type::eof()) {
+            return;
+        }
+        metrics.start();
 
-                    headerValue += '\n';
-                    stream >> ignorews;
-                }
+        try {
+            request = {};
 
-                auto &&it = request.headers.find(headerName);
-                if (it != request.headers.end()) {
-                    it->second += ", ";
-                    it->second += headerValue;
-                } else {
-                    request.headers[headerName] = headerValue;
-                }
-            }
+            deadline.set(options.headerTimeout);
+            std::istringstream head(readHead(stream, options.maxHeaderBytes));
+            readRequestHead(head, request);
 
-            auto &&it = request.headers.find("content-length");
-            if (it != request.headers.end()) {
-                int contentLength = std::stoi(it->second);
-                char *body = new char[contentLength + 1];
-                stream.read(body, contentLength);
-                body[contentLength] = '\0';
+            size_t contentLength = getContentLength(request);
+            if (contentLength > options.maxBodyBytes) {
+                throw PayloadTooLargeError();
             }
+            if (contentLength) {
+                deadline.set(options.bodyTimeout);
+                request.body.resize(contentLength);
+                if (!stream.read(request.body.data(), contentLength)) {
+                    return;
+                }
+            }
+            deadline.cancel();
+            metrics.lap(ServerMetrics::Phase::Parse);
 
             std::unique_ptr<Response> response = handler(request);
-            stream << *response.get() << std::flush;
+            metrics.lap(ServerMetrics::Phase::Handler);
+
+            deadline.set(options.writeTimeout);
+            writeResponse(stream, *response.get(), request, options.compression);
+            // Requests the client pipelined are already in the input buffer;
+            // their responses are batched with this one into a single send
+            if (!stream.rdbuf()->in_avail()) {
+                stream.flush();
+            }
+            metrics.lap(ServerMetrics::Phase::Write);
+            metrics.countResponse(response->status);
 
         } catch (const HttpError &e) {
+            deadline.set(options.writeTimeout);
             stream << e;
+            metrics.countResponse(e.status);
 
             if (e.closeConnection) {
                 return;
             }
+        } catch (const std::exception &e) {
+            // A failing handler must not take the whole server down with it
+            HTTP_LOG("> Request failed: \"" << e.what() << '"');
+            InternalServerError error;
+            deadline.set(options.writeTimeout);
+            stream << error;
+            metrics.countResponse(error.status);
+            return;
+        }
+
+        if (!stream) {
+            return;
         }
 
         auto &&it = request.headers.find("connection");
@@ -191,6 +305,7 @@ std::ostream &operator<<(std::ostream &stream, const HttpError &error)
     stream << "HTTP/1.1 " << error.status << ' ' << error.message << net::endl
            << "Content-Length: 0" << net::endl
            << "Connection: " << (error.closeConnection ? "close" : "keep-alive") << net::endl
+           << net::endl
            << std::flush;
     return stream;
 }
@@ -211,20 +326,69 @@ std::ostream &operator<<(std::ostream &stream, const Request &request)
     return stream;
 }
 
-std::ostream &operator<<(std::ostream &stream, const Response &response)
+static std::ostream &writeResponse(std::ostream &stream, const Response &response, ContentEncoding encoding, int level)
 {
-    std::cout << "> Writing response" << std::endl;
+    HTTP_LOG("> Writing response");
     stream << "HTTP/1.1 " << response.status << ' ' << response.message << net::endl;
 
+    // Compressed size isn't known until the body is written, so compressed
+    // bodies, like those of unknown length, are sent in chunks
+    bool chunked = encoding != ContentEncoding::Identity || !response.headers.contains("Content-Length");
     for (auto &&it : response.headers) {
+        if (encoding != ContentEncoding::Identity && it.first == "Content-Length") {
+            continue;
+        }
         stream << it.first << ": " << it.second << net::endl;
     }
+    if (encoding != ContentEncoding::Identity) {
+        stream << "Content-Encoding: " << encodingName(encoding) << net::endl << "Vary: Accept-Encoding" << net::endl;
+    }
+    if (chunked) {
+        stream << "Transfer-Encoding: chunked" << net::endl;
+    }
     stream << net::endl;
-    response.writeBody(stream);
 
+    if (!chunked) {
+        response.writeBody(stream);
+        return stream;
+    }
+
+    // writeBody -> [deflate] -> chunk framing -> stream
+    bool written;
+    ChunkedStreamBuffer chunks(stream.rdbuf());
+    if (encoding == ContentEncoding::Identity) {
+        std::ostream body(&chunks);
+        response.writeBody(body);
+        written = body && chunks.finish();
+    } else {
+        DeflateStreamBuffer deflater(&chunks, encoding, level);
+        std::ostream body(&deflater);
+        response.writeBody(body);
+        written = body && deflater.finish() && chunks.finish();
+    }
+
+    if (!written) {
+        stream.setstate(std::ios::badbit);
+    }
     return stream;
 }
 
+std::ostream &writeResponse(std::ostream &stream, const Response &response, const Request &request,
+                            const CompressionOptions &compression)
+{
+    auto &&acceptEncoding = request.headers.find("accept-encoding");
+    ContentEncoding encoding =
+        acceptEncoding == request.headers.end()
+            ? ContentEncoding::Identity
+            : negotiateEncoding(acceptEncoding->second, response.headers, compression);
+    return writeResponse(stream, response, encoding, compression.level);
+}
+
+std::ostream &operator<<(std::ostream &stream, const Response &response)
+{
+    return writeResponse(stream, response, ContentEncoding::Identity, Z_DEFAULT_COMPRESSION);
+}
+
 Response::Response() : status(200), message("OK")
 {
 }
@@ -236,6 +400,93 @@ Response::Response(const int status, const std::string &message, const std::map<
 {
 }
 
+namespace
+{
+    constexpr size_t POOL_GRANULARITY = 64;
+    constexpr size_t POOL_CLASSES = 8;
+    constexpr size_t POOL_MAX_FREE = 64;
+
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    struct ResponsePool {
+        FreeBlock *heads[POOL_CLASSES] = {};
+        size_t sizes[POOL_CLASSES] = {};
+
+        ~ResponsePool()
+        {
+            for (FreeBlock *head : heads) {
+                while (head) {
+                    FreeBlock *next = head->next;
+                    ::operator delete(head);
+                    head = next;
+                }
+            }
+        }
+    };
+
+    thread_local ResponsePool responsePool;
+
+    size_t poolClass(size_t size)
+    {
+        return (size + POOL_GRANULARITY - 1) / POOL_GRANULARITY - 1;
+    }
+} // namespace
+
+void *Response::operator new(size_t size)
+{
+    size_t c = poolClass(size);
+    if (c >= POOL_CLASSES) {
+        return ::operator new(size);
+    }
+
+    if (FreeBlock *block = responsePool.heads[c]) {
+        responsePool.heads[c] = block->next;
+        responsePool.sizes[c]--;
+        return block;
+    }
+    return ::operator new((c + 1) * POOL_GRANULARITY);
+}
+
+void Response::operator delete(void *pointer, size_t size)
+{
+    size_t c = poolClass(size);
+    if (c >= POOL_CLASSES || responsePool.sizes[c] >= POOL_MAX_FREE) {
+        ::operator delete(pointer);
+        return;
+    }
+
+    auto *block = static_cast<FreeBlock *>(pointer);
+    block->next = responsePool.heads[c];
+    responsePool.heads[c] = block;
+    responsePool.sizes[c]++;
+}
+
+static std::map<std::string, std::string> getStringResponseHeaders(const std::string &body, const std::string &contentType)
+{
+    return {{"Content-Length", std::to_string(body.size())}, {"Content-Type", contentType}};
+}
+
+StringResponse::StringResponse(const std::string &body, const std::string &contentType)
+    : Response(getStringResponseHeaders(body, contentType)), body(body)
+{
+}
+StringResponse::StringResponse(
+    const int status,
+    const std::string &message,
+    const std::string &body,
+    const std::string &contentType
+)
+    : Response(status, message, getStringResponseHeaders(body, contentType)), body(body)
+{
+}
+
+std::ostream &StringResponse::writeBody(std::ostream &stream) const
+{
+    return stream.write(body.data(), body.size());
+}
+
 static std::string HTML_EXTENSION = ".html";
 static std::string JPEG_EXTENSION = ".jpg";
 
@@ -261,16 +512,21 @@ FileResponse::FileResponse(const std::filesystem::path &path) : Response(getFile
 
 std::ostream &FileResponse::writeBody(std::ostream &stream) const
 {
-    std::ifstream fileStream(path);
+    if (auto *networkStream = dynamic_cast<NetworkStream *>(&stream)) {
+        if (networkStream->sendFile(path).fail() && !networkStream->bad()) {
+            networkStream->clear();
+            throw NotFoundError();
+        }
+        return stream;
+    }
+
+    std::ifstream fileStream(path, std::ios::binary);
 
     if (!fileStream) {
         throw NotFoundError();
     }
 
-    while (fileStream.peek() != EOF) {
-        stream << static_cast<char>(fileStream.get());
-    }
-
+    stream << fileStream.rdbuf();
     return stream;
 }
 
@@ -290,6 +546,20 @@ NotFoundError::NotFoundError() : HttpError(404, "Not Found")
 MethodNotAllowedError::MethodNotAllowedError() : HttpError(405, "Method Not Allowed")
 {
 }
+PayloadTooLargeError::PayloadTooLargeError() : HttpError(413, "Payload Too Large", true)
+{
+}
+RequestHeaderFieldsTooLargeError::RequestHeaderFieldsTooLargeError()
+    : HttpError(431, "Request Header Fields Too Large", true)
+{
+}
+InternalServerError::InternalServerError() : HttpError(500, "Internal Server Error", true)
+{
+}
+
+ServiceUnavailableError::ServiceUnavailableError() : HttpError(503, "Service Unavailable")
+{
+}
 HttpVersionNotSupportedError::HttpVersionNotSupportedError() : HttpError(505, "HTTP Version Not Supported")
 {
 }
\ No newline at end of file
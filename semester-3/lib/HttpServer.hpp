@@ -1,9 +1,17 @@
 #pragma once
+#include "ContentEncoding.hpp"
 #include "NetworkStream.hpp"
+#include "ServerMetrics.hpp"
+#include "TimerWheel.hpp"
+#include <sys/socket.h>
+
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <map>
 #include <memory>
+#include <semaphore>
 #include <string>
 
 struct Request;
@@ -11,7 +19,7 @@ struct Response;
 struct FileResponse;
 class HttpError;
 
-using RequestHandler = std::unique_ptr<Response> (*)(const Request &request);
+using RequestHandler = std::function<std::unique_ptr<Response>(const Request &request)>;
 
 struct Request {
   public:
@@ -34,6 +42,27 @@ struct Response {
     virtual ~Response() = default;
 
     virtual std::ostream &writeBody(std::ostream &stream) const = 0;
+
+    // Responses live for exactly one request, so their storage is recycled
+    // through a per-thread pool instead of going back to the heap.
+    static void *operator new(size_t size);
+    static void operator delete(void *pointer, size_t size);
+};
+
+struct StringResponse : public Response {
+  private:
+    std::string body;
+
+  public:
+    StringResponse(const std::string &body, const std::string &contentType = "text/plain");
+    StringResponse(
+        const int status,
+        const std::string &message,
+        const std::string &body,
+        const std::string &contentType = "text/plain"
+    );
+
+    virtual std::ostream &writeBody(std::ostream &stream) const override;
 };
 
 struct FileResponse : public Response {
@@ -46,22 +75,63 @@ struct FileResponse : public Response {
     virtual std::ostream &writeBody(std::ostream &stream) const override;
 };
 
+struct HttpServerOptions {
+    // Connections past this limit wait in the listen backlog until a slot
+    // frees up, instead of each getting a thread
+    size_t maxConnections = 256;
+    int backlog = SOMAXCONN;
+
+    size_t maxHeaderBytes = 8 * 1024;
+    size_t maxBodyBytes = 1024 * 1024;
+
+    // Time a keep-alive connection may wait for the next request
+    std::chrono::seconds idleTimeout {60};
+    // Time from the first byte of a request to the end of its headers
+    std::chrono::seconds headerTimeout {10};
+    std::chrono::seconds bodyTimeout {30};
+    // Time a client may take to accept a response; writes block once the
+    // output buffer is full, so a slow reader can't queue up unbounded data
+    std::chrono::seconds writeTimeout {30};
+
+    size_t inputBufferSize = DEFAULT_INPUT_BUFFER_SIZE;
+    size_t outputBufferSize = DEFAULT_OUTPUT_BUFFER_SIZE;
+
+    CompressionOptions compression;
+
+    // Where to record request counts and phase timings, if anywhere
+    ServerMetrics *metrics = nullptr;
+};
+
+// Thread-per-connection server. Every phase of a connection has a deadline
+// on a shared timer wheel; when it passes, the socket is shut down, which
+// unblocks the connection thread and makes it close the connection.
 class HttpServer
 {
   private:
     int masterSocketFd;
+    const HttpServerOptions options;
+    TimerWheel timers;
+    std::counting_semaphore<> connectionSlots;
 
-    void serve(RequestHandler handler) const;
-    void handle(NetworkStream &stream, RequestHandler handler) const;
+    void serve(const RequestHandler &handler);
+    void handle(NetworkStream &stream, const RequestHandler &handler, ServerMetrics::Recorder &metrics);
 
   public:
-    HttpServer(const std::string &port, RequestHandler handler);
+    HttpServer(const std::string &port, RequestHandler handler, const HttpServerOptions &options = {});
     ~HttpServer();
 };
 
+// Parses the request line and headers; throws HttpError on malformed input
+void readRequestHead(std::istream &stream, Request &request);
+size_t getContentLength(const Request &request);
+
 std::ostream &operator<<(std::ostream &stream, const HttpError &error);
 std::ostream &operator<<(std::ostream &stream, const Request &request);
 std::ostream &operator<<(std::ostream &stream, const Response &request);
+// Writes the response compressed if the request's Accept-Encoding and the
+// response's content type allow it, chunked if its length isn't known
+std::ostream &writeResponse(std::ostream &stream, const Response &response, const Request &request,
+                            const CompressionOptions &compression = {});
 
 class HttpError : std::exception
 {
@@ -97,6 +167,30 @@ class MethodNotAllowedError : public HttpError
     MethodNotAllowedError();
 };
 
+class PayloadTooLargeError : public HttpError
+{
+  public:
+    PayloadTooLargeError();
+};
+
+class RequestHeaderFieldsTooLargeError : public HttpError
+{
+  public:
+    RequestHeaderFieldsTooLargeError();
+};
+
+class InternalServerError : public HttpError
+{
+  public:
+    InternalServerError();
+};
+
+class ServiceUnavailableError : public HttpError
+{
+  public:
+    ServiceUnavailableError();
+};
+
 class HttpVersionNotSupportedError : public HttpError
 {
   public:
@@ -0,0 +1,561 @@
+#include "IoUringEventLoop.hpp"
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+constexpr unsigned short RECV_BUFFER_GROUP = 0;
+constexpr size_t MAX_LINKED_SENDS = 64;
+
+static int io_uring_setup(unsigned entries, io_uring_params *params)
+{
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int io_uring_enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0);
+}
+
+static int io_uring_register(int fd, unsigned opcode, void *arg, unsigned count)
+{
+    return syscall(__NR_io_uring_register, fd, opcode, arg, count);
+}
+
+static std::runtime_error uringError(const std::string &what)
+{
+    return std::runtime_error(what + ": \"" + std::strerror(errno) + '"');
+}
+
+// Single-shot request awaited by one coroutine
+struct IoUringEventLoop::Operation : Completion {
+    std::coroutine_handle<> handle;
+    int result = 0;
+    unsigned flags = 0;
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+    void await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle = awaiting;
+    }
+    int await_resume() const noexcept
+    {
+        return result;
+    }
+
+    virtual void complete(int result, unsigned flags) override
+    {
+        this->result = result;
+        this->flags = flags;
+        handle.resume();
+    }
+};
+
+// Chain of IOSQE_IO_LINK sends; the coroutine resumes after the last one
+struct IoUringEventLoop::LinkedSend {
+    struct Link : Completion {
+        LinkedSend *chain = nullptr;
+        int result = 0;
+
+        virtual void complete(int result, unsigned flags) override
+        {
+            this->result = result;
+            if (!--chain->remaining) chain->handle.resume();
+        }
+    };
+
+    std::vector<Link> links;
+    size_t remaining;
+    std::coroutine_handle<> handle;
+
+    LinkedSend(size_t count) : links(count), remaining(count)
+    {
+        for (auto &&link : links) link.chain = this;
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+    void await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle = awaiting;
+    }
+    void await_resume() const noexcept
+    {
+    }
+};
+
+// State of a multishot accept: the kernel keeps posting accepted sockets,
+// which queue up here until a coroutine asks for them
+struct IoUringEventLoop::Acceptor : Completion {
+    IoUringEventLoop &loop;
+    int fd;
+    bool armed = false;
+    bool multishot = true;
+    bool closing = false;
+    std::deque<int> ready;
+    std::coroutine_handle<> waiter;
+
+    Acceptor(IoUringEventLoop &loop, int fd) : loop(loop), fd(fd)
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+        return !ready.empty();
+    }
+    void await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        waiter = awaiting;
+    }
+    void await_resume() const noexcept
+    {
+    }
+
+    virtual void complete(int result, unsigned flags) override
+    {
+        if (!(flags & IORING_CQE_F_MORE)) armed = false;
+
+        if (closing) {
+            if (result >= 0) close(result);
+            if (!armed) loop.releaseAcceptor(this);
+            return;
+        }
+
+        if (result == -EINVAL && multishot) {
+            multishot = false;
+        } else {
+            ready.push_back(result);
+        }
+
+        if (waiter) {
+            if (!ready.empty()) {
+                std::exchange(waiter, nullptr).resume();
+            } else if (!armed) {
+                loop.armAccept(*this);
+            }
+        }
+    }
+};
+
+IoUringEventLoop::IoUringEventLoop(unsigned entries)
+{
+    // A throwing constructor doesn't get its destructor run, and create()
+    // relies on this throwing to fall back to epoll, so whatever was set up
+    // by then is released here
+    try {
+        setupRings(entries);
+        setupBufferRing();
+        setupFixedFiles();
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+IoUringEventLoop::~IoUringEventLoop()
+{
+    release();
+}
+
+void IoUringEventLoop::release()
+{
+    if (sqes) munmap(sqes, sqEntries * sizeof(io_uring_sqe));
+    if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+    if (sqRing) munmap(sqRing, sqRingSize);
+    if (ringFd >= 0) close(ringFd);
+    std::free(bufferRing);
+
+    sqes = nullptr;
+    sqRing = cqRing = nullptr;
+    ringFd = -1;
+    bufferRing = nullptr;
+}
+
+void IoUringEventLoop::setupRings(unsigned entries)
+{
+    io_uring_params params {};
+    ringFd = io_uring_setup(entries, &params);
+    if (ringFd < 0) {
+        throw uringError("Unable to set up io_uring");
+    }
+
+    sqEntries = params.sq_entries;
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        sqRing = nullptr;
+        throw uringError("Unable to map submission queue");
+    }
+    if (singleMmap) {
+        cqRing = sqRing;
+    } else {
+        cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            cqRing = nullptr;
+            throw uringError("Unable to map completion queue");
+        }
+    }
+
+    void *sqesMemory = mmap(
+        nullptr,
+        sqEntries * sizeof(io_uring_sqe),
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        ringFd,
+        IORING_OFF_SQES
+    );
+    if (sqesMemory == MAP_FAILED) {
+        throw uringError("Unable to map submission queue entries");
+    }
+    sqes = static_cast<io_uring_sqe *>(sqesMemory);
+
+    auto *sq = static_cast<char *>(sqRing);
+    sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+    auto *cq = static_cast<char *>(cqRing);
+    cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+}
+
+void IoUringEventLoop::setupBufferRing()
+{
+    size_t ringSize = IO_URING_RECV_BUFFERS * sizeof(io_uring_buf);
+    // The kernel wants the ring page aligned
+    void *ring = std::aligned_alloc(sysconf(_SC_PAGESIZE), ringSize);
+    if (!ring) return;
+    std::memset(ring, 0, ringSize);
+
+    io_uring_buf_reg registration {};
+    registration.ring_addr = reinterpret_cast<uintptr_t>(ring);
+    registration.ring_entries = IO_URING_RECV_BUFFERS;
+    registration.bgid = RECV_BUFFER_GROUP;
+    if (io_uring_register(ringFd, IORING_REGISTER_PBUF_RING, &registration, 1) < 0) {
+        std::free(ring);
+        return;
+    }
+
+    bufferRing = static_cast<io_uring_buf_ring *>(ring);
+    bufferMemory.reset(new char[IO_URING_RECV_BUFFERS * IO_URING_RECV_BUFFER_SIZE]);
+    for (unsigned id = 0; id < IO_URING_RECV_BUFFERS; id++) {
+        recycleBuffer(id);
+    }
+}
+
+void IoUringEventLoop::setupFixedFiles()
+{
+    std::vector<int> files(IO_URING_FIXED_FILES, -1);
+    if (io_uring_register(ringFd, IORING_REGISTER_FILES, files.data(), files.size()) == 0) {
+        fixedFiles.assign(IO_URING_FIXED_FILES, false);
+    }
+}
+
+const char *IoUringEventLoop::name() const
+{
+    return "io_uring";
+}
+
+void IoUringEventLoop::recycleBuffer(unsigned short id)
+{
+    unsigned short tail = bufferRing->tail;
+    // Not bufferRing->bufs: in C++ the kernel header's flex array macro shifts it by 8 bytes
+    io_uring_buf &buffer = reinterpret_cast<io_uring_buf *>(bufferRing)[tail & (IO_URING_RECV_BUFFERS - 1)];
+    buffer.addr = reinterpret_cast<uintptr_t>(bufferMemory.get() + id * IO_URING_RECV_BUFFER_SIZE);
+    buffer.len = IO_URING_RECV_BUFFER_SIZE;
+    buffer.bid = id;
+    __atomic_store_n(&bufferRing->tail, static_cast<unsigned short>(tail + 1), __ATOMIC_RELEASE);
+}
+
+void IoUringEventLoop::updateFixedFile(int fd, int value)
+{
+    io_uring_files_update update {};
+    update.offset = fd;
+    update.fds = reinterpret_cast<uintptr_t>(&value);
+    bool registered = io_uring_register(ringFd, IORING_REGISTER_FILES_UPDATE, &update, 1) == 1;
+    fixedFiles[fd] = registered && value >= 0;
+}
+
+void IoUringEventLoop::add(int fd)
+{
+    if (static_cast<size_t>(fd) < fixedFiles.size()) {
+        updateFixedFile(fd, fd);
+    }
+}
+
+void IoUringEventLoop::remove(int fd)
+{
+    auto it = acceptors.find(fd);
+    if (it != acceptors.end()) {
+        Acceptor &acceptor = *it->second;
+        acceptor.closing = true;
+        if (acceptor.armed) {
+            io_uring_sqe *sqe = prepare(IORING_OP_ASYNC_CANCEL, -1, nullptr);
+            sqe->addr = reinterpret_cast<uintptr_t>(static_cast<Completion *>(&acceptor));
+            closingAcceptors.push_back(std::move(it->second));
+            submit();
+        }
+        acceptors.erase(it);
+    }
+
+    if (static_cast<size_t>(fd) < fixedFiles.size() && fixedFiles[fd]) {
+        updateFixedFile(fd, -1);
+    }
+}
+
+void IoUringEventLoop::releaseAcceptor(Acceptor *acceptor)
+{
+    std::erase_if(closingAcceptors, [acceptor](const std::unique_ptr<Acceptor> &closing) {
+        return closing.get() == acceptor;
+    });
+}
+
+void IoUringEventLoop::reserve(unsigned count)
+{
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    if (*sqTail - head + count > sqEntries) {
+        submit();
+    }
+}
+
+io_uring_sqe *IoUringEventLoop::prepare(int opcode, int fd, Completion *completion)
+{
+    reserve(1);
+
+    // Without SQPOLL the kernel only looks at the ring during io_uring_enter(),
+    // so publishing the tail before the caller fills in the rest is fine
+    unsigned tail = *sqTail;
+    unsigned index = tail & *sqMask;
+    io_uring_sqe *sqe = &sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    if (fd >= 0 && static_cast<size_t>(fd) < fixedFiles.size() && fixedFiles[fd]) {
+        sqe->flags |= IOSQE_FIXED_FILE;
+    }
+    sqe->user_data = reinterpret_cast<uintptr_t>(completion);
+
+    sqArray[index] = index;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    pending++;
+    return sqe;
+}
+
+void IoUringEventLoop::submit()
+{
+    while (pending) {
+        int submitted = io_uring_enter(ringFd, pending, 0, 0);
+        if (submitted < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EBUSY) {
+                reap();
+                continue;
+            }
+            throw uringError("io_uring_enter() call failed");
+        }
+        pending -= submitted;
+    }
+}
+
+void IoUringEventLoop::reap()
+{
+    unsigned head = *cqHead;
+    while (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+        io_uring_cqe cqe = cqes[head & *cqMask];
+        __atomic_store_n(cqHead, ++head, __ATOMIC_RELEASE);
+
+        if (cqe.user_data) {
+            reinterpret_cast<Completion *>(cqe.user_data)->complete(cqe.res, cqe.flags);
+        }
+        head = *cqHead;
+    }
+}
+
+void IoUringEventLoop::armAccept(Acceptor &acceptor)
+{
+    io_uring_sqe *sqe = prepare(IORING_OP_ACCEPT, acceptor.fd, &acceptor);
+    sqe->accept_flags = SOCK_CLOEXEC;
+    if (acceptor.multishot) {
+        sqe->ioprio |= IORING_ACCEPT_MULTISHOT;
+    }
+    acceptor.armed = true;
+}
+
+Task<int> IoUringEventLoop::accept(int fd)
+{
+    auto &slot = acceptors[fd];
+    if (!slot) {
+        slot.reset(new Acceptor(*this, fd));
+    }
+    Acceptor &acceptor = *slot;
+
+    while (acceptor.ready.empty()) {
+        if (!acceptor.armed) {
+            armAccept(acceptor);
+        }
+        co_await acceptor;
+    }
+
+    int client = acceptor.ready.front();
+    acceptor.ready.pop_front();
+    co_return client;
+}
+
+Task<int> IoUringEventLoop::connect(int fd, const sockaddr *address, socklen_t length)
+{
+    Operation operation;
+    io_uring_sqe *sqe = prepare(IORING_OP_CONNECT, fd, &operation);
+    sqe->addr = reinterpret_cast<uintptr_t>(address);
+    sqe->off = length;
+    co_return co_await operation;
+}
+
+Task<ssize_t> IoUringEventLoop::recv(int fd, std::span<char> buffer)
+{
+    if (bufferRing) {
+        Operation operation;
+        io_uring_sqe *sqe = prepare(IORING_OP_RECV, fd, &operation);
+        sqe->flags |= IOSQE_BUFFER_SELECT;
+        sqe->buf_group = RECV_BUFFER_GROUP;
+        sqe->len = std::min<size_t>(buffer.size(), IO_URING_RECV_BUFFER_SIZE);
+        co_await operation;
+
+        if (operation.flags & IORING_CQE_F_BUFFER) {
+            unsigned short id = operation.flags >> IORING_CQE_BUFFER_SHIFT;
+            if (operation.result > 0) {
+                std::memcpy(buffer.data(), bufferMemory.get() + id * IO_URING_RECV_BUFFER_SIZE, operation.result);
+            }
+            recycleBuffer(id);
+        }
+        // -ENOBUFS: every ring buffer is in use, receive into the caller's one
+        if (operation.result != -ENOBUFS) {
+            co_return operation.result;
+        }
+    }
+
+    Operation operation;
+    io_uring_sqe *sqe = prepare(IORING_OP_RECV, fd, &operation);
+    sqe->addr = reinterpret_cast<uintptr_t>(buffer.data());
+    sqe->len = buffer.size();
+    co_return co_await operation;
+}
+
+Task<ssize_t> IoUringEventLoop::sendOne(int fd, std::string_view data)
+{
+    ssize_t total = 0;
+    while (!data.empty()) {
+        Operation operation;
+        io_uring_sqe *sqe = prepare(IORING_OP_SEND, fd, &operation);
+        sqe->addr = reinterpret_cast<uintptr_t>(data.data());
+        sqe->len = data.size();
+        sqe->msg_flags = MSG_NOSIGNAL;
+
+        int sent = co_await operation;
+        if (sent < 0) {
+            co_return sent;
+        }
+        data.remove_prefix(sent);
+        total += sent;
+    }
+    co_return total;
+}
+
+Task<ssize_t> IoUringEventLoop::send(int fd, std::span<const std::string_view> parts)
+{
+    std::vector<std::string_view> chain;
+    for (auto &&part : parts) {
+        if (!part.empty()) chain.push_back(part);
+    }
+    if (chain.empty()) {
+        co_return 0;
+    }
+
+    ssize_t total = 0;
+    size_t done = 0;
+    if (chain.size() > 1 && chain.size() <= std::min<size_t>(MAX_LINKED_SENDS, sqEntries)) {
+        // All links must go to the kernel in the same io_uring_enter() call
+        reserve(chain.size());
+
+        LinkedSend linked(chain.size());
+        for (size_t i = 0; i < chain.size(); i++) {
+            io_uring_sqe *sqe = prepare(IORING_OP_SEND, fd, &linked.links[i]);
+            sqe->addr = reinterpret_cast<uintptr_t>(chain[i].data());
+            sqe->len = chain[i].size();
+            // A short send fails the link, so later parts can't overtake it
+            sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+            if (i + 1 < chain.size()) sqe->flags |= IOSQE_IO_LINK;
+        }
+        co_await linked;
+
+        for (; done < chain.size(); done++) {
+            int sent = linked.links[done].result;
+            if (sent == static_cast<int>(chain[done].size())) {
+                total += sent;
+                continue;
+            }
+            if (sent < 0 && sent != -ECANCELED) {
+                co_return sent;
+            }
+            if (sent > 0) {
+                total += sent;
+                chain[done].remove_prefix(sent);
+            }
+            break;
+        }
+    }
+
+    // Whatever the chain didn't deliver (or everything, if it wasn't used)
+    for (; done < chain.size(); done++) {
+        ssize_t sent = co_await sendOne(fd, chain[done]);
+        if (sent < 0) {
+            co_return sent;
+        }
+        total += sent;
+    }
+    co_return total;
+}
+
+void IoUringEventLoop::run()
+{
+    while (!stopped) {
+        int submitted = io_uring_enter(ringFd, pending, 1, IORING_ENTER_GETEVENTS);
+        if (submitted < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EBUSY) {
+                throw uringError("io_uring_enter() call failed");
+            }
+        } else {
+            pending -= std::min<unsigned>(submitted, pending);
+        }
+        reap();
+    }
+}
+
+void IoUringEventLoop::stop()
+{
+    stopped = true;
+}
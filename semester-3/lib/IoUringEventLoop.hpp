@@ -0,0 +1,88 @@
+#pragma once
+#include "EventLoop.hpp"
+#include <linux/io_uring.h>
+
+#include <coroutine>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+constexpr unsigned IO_URING_ENTRIES = 4096;
+constexpr unsigned IO_URING_FIXED_FILES = 4096;
+constexpr unsigned IO_URING_RECV_BUFFERS = 256;
+constexpr unsigned IO_URING_RECV_BUFFER_SIZE = 16 * 1024;
+
+// Completion-based backend talking to io_uring through raw syscalls:
+// - listening sockets use one multishot accept instead of an accept per client;
+// - receives take buffers from a provided buffer ring picked by the kernel;
+// - gathered writes become a chain of linked sends, submitted together;
+// - registered sockets live in the fixed file table, so requests skip the
+//   per-operation file descriptor lookup.
+// Each feature is dropped individually when the kernel rejects it.
+class IoUringEventLoop : public EventLoop
+{
+  private:
+    struct Completion {
+        virtual void complete(int result, unsigned flags) = 0;
+
+      protected:
+        ~Completion() = default;
+    };
+    struct Operation;
+    struct LinkedSend;
+    struct Acceptor;
+
+    int ringFd = -1;
+    bool stopped = false;
+    unsigned pending = 0;
+
+    void *sqRing = nullptr, *cqRing = nullptr;
+    size_t sqRingSize = 0, cqRingSize = 0;
+    unsigned sqEntries = 0;
+    unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+    io_uring_sqe *sqes = nullptr;
+    unsigned *cqHead, *cqTail, *cqMask;
+    io_uring_cqe *cqes;
+
+    io_uring_buf_ring *bufferRing = nullptr;
+    std::unique_ptr<char[]> bufferMemory;
+
+    std::vector<bool> fixedFiles;
+    std::unordered_map<int, std::unique_ptr<Acceptor>> acceptors;
+    std::vector<std::unique_ptr<Acceptor>> closingAcceptors;
+
+    void setupRings(unsigned entries);
+    void setupBufferRing();
+    void setupFixedFiles();
+    // Unmaps the rings and closes the ring, whichever of them exist
+    void release();
+
+    io_uring_sqe *prepare(int opcode, int fd, Completion *completion);
+    void reserve(unsigned count);
+    void submit();
+    void reap();
+
+    void recycleBuffer(unsigned short id);
+    void updateFixedFile(int fd, int value);
+    void armAccept(Acceptor &acceptor);
+    void releaseAcceptor(Acceptor *acceptor);
+
+    Task<ssize_t> sendOne(int fd, std::string_view data);
+
+  public:
+    IoUringEventLoop(unsigned entries = IO_URING_ENTRIES);
+    virtual ~IoUringEventLoop();
+
+    virtual const char *name() const override;
+
+    virtual void add(int fd) override;
+    virtual void remove(int fd) override;
+
+    virtual Task<int> accept(int fd) override;
+    virtual Task<int> connect(int fd, const sockaddr *address, socklen_t length) override;
+    virtual Task<ssize_t> recv(int fd, std::span<char> buffer) override;
+    virtual Task<ssize_t> send(int fd, std::span<const std::string_view> parts) override;
+
+    virtual void run() override;
+    virtual void stop() override;
+};
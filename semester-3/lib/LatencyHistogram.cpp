@@ -0,0 +1,171 @@
+#include "LatencyHistogram.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+#include <stdexcept>
+
+LatencyHistogram::LatencyHistogram(uint64_t highestTrackable, int significantDigits)
+    : highestTrackable(highestTrackable)
+{
+    if (significantDigits < 1 || significantDigits > 5 || highestTrackable < 2) {
+        throw std::invalid_argument("Unsupported histogram precision or range");
+    }
+
+    // Enough sub-buckets to tell apart values differing in the last significant digit
+    uint64_t largestSingleUnitResolution = 2 * static_cast<uint64_t>(std::pow(10, significantDigits));
+    uint64_t subBucketCount = std::bit_ceil(largestSingleUnitResolution);
+    subBucketHalfCountMagnitude = std::countr_zero(subBucketCount) - 1;
+    subBucketHalfCount = subBucketCount / 2;
+    subBucketMask = subBucketCount - 1;
+
+    size_t bucketCount = 1;
+    for (uint64_t limit = subBucketCount; limit <= highestTrackable && limit < (UINT64_MAX >> 1); limit <<= 1) {
+        bucketCount++;
+    }
+    counts.assign((bucketCount + 1) * subBucketHalfCount, 0);
+}
+
+size_t LatencyHistogram::indexOf(uint64_t value) const
+{
+    int bucket = 64 - std::countl_zero(value | subBucketMask) - (subBucketHalfCountMagnitude + 1);
+    uint64_t subBucket = value >> bucket;
+    return ((bucket + 1) << subBucketHalfCountMagnitude) + (subBucket - subBucketHalfCount);
+}
+
+uint64_t LatencyHistogram::lowestAt(size_t index) const
+{
+    int bucket = static_cast<int>(index >> subBucketHalfCountMagnitude) - 1;
+    uint64_t subBucket = (index & (subBucketHalfCount - 1)) + subBucketHalfCount;
+    if (bucket < 0) {
+        subBucket -= subBucketHalfCount;
+        bucket = 0;
+    }
+    return subBucket << bucket;
+}
+
+uint64_t LatencyHistogram::highestAt(size_t index) const
+{
+    return index + 1 < counts.size() ? lowestAt(index + 1) - 1 : highestTrackable;
+}
+
+void LatencyHistogram::record(uint64_t value, uint64_t count)
+{
+    value = std::min(value, highestTrackable);
+    counts[indexOf(value)] += count;
+
+    total += count;
+    minimum = std::min(minimum, value);
+    maximum = std::max(maximum, value);
+    sum += static_cast<double>(value) * count;
+    sumOfSquares += static_cast<double>(value) * value * count;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    if (other.counts.size() != counts.size() || other.subBucketHalfCount != subBucketHalfCount) {
+        throw std::invalid_argument("Histograms have different layouts");
+    }
+
+    for (size_t i = 0; i < counts.size(); i++) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+    minimum = std::min(minimum, other.minimum);
+    maximum = std::max(maximum, other.maximum);
+    sum += other.sum;
+    sumOfSquares += other.sumOfSquares;
+}
+
+void LatencyHistogram::reset()
+{
+    std::fill(counts.begin(), counts.end(), 0);
+    total = 0;
+    minimum = UINT64_MAX;
+    maximum = 0;
+    sum = sumOfSquares = 0;
+}
+
+uint64_t LatencyHistogram::count() const
+{
+    return total;
+}
+
+uint64_t LatencyHistogram::min() const
+{
+    return total ? minimum : 0;
+}
+
+uint64_t LatencyHistogram::max() const
+{
+    return maximum;
+}
+
+double LatencyHistogram::mean() const
+{
+    return total ? sum / total : 0;
+}
+
+double LatencyHistogram::stddev() const
+{
+    if (!total) {
+        return 0;
+    }
+    double m = mean();
+    return std::sqrt(std::max(0.0, sumOfSquares / total - m * m));
+}
+
+uint64_t LatencyHistogram::valueAt(double percentile) const
+{
+    if (!total) {
+        return 0;
+    }
+
+    uint64_t target = std::max<uint64_t>(1, std::ceil(std::clamp(percentile, 0.0, 100.0) / 100 * total));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+        if (seen >= target) {
+            return std::min(highestAt(i), maximum);
+        }
+    }
+    return maximum;
+}
+
+void LatencyHistogram::print(std::ostream &stream, double unitScale, int ticksPerHalfDistance) const
+{
+    stream << std::setw(12) << "Value" << ' ' << std::setw(14) << "Percentile" << ' ' << std::setw(10) << "TotalCount"
+           << ' ' << std::setw(14) << "1/(1-Percentile)" << "\n\n";
+
+    std::ios::fmtflags flags = stream.flags();
+    stream << std::fixed;
+
+    // Steps halve the remaining distance to 100% every `ticksPerHalfDistance` lines
+    double percentile = 0;
+    while (true) {
+        uint64_t value = valueAt(percentile);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size() && lowestAt(i) <= value; i++) {
+            seen += counts[i];
+        }
+
+        stream << std::setw(12) << std::setprecision(3) << value / unitScale << ' ' << std::setw(14)
+               << std::setprecision(12) << percentile / 100 << ' ' << std::setw(10) << seen;
+        if (percentile < 100) {
+            stream << ' ' << std::setw(14) << std::setprecision(2) << 1 / (1 - percentile / 100);
+        }
+        stream << '\n';
+
+        if (percentile >= 100 || value >= maximum) {
+            break;
+        }
+        double halfDistance = std::pow(2, std::floor(std::log2(100 / (100 - percentile))) + 1);
+        percentile += 100 / (halfDistance * ticksPerHalfDistance);
+    }
+
+    stream << std::setprecision(3) << "#[Mean    = " << std::setw(12) << mean() / unitScale
+           << ", StdDeviation   = " << std::setw(12) << stddev() / unitScale << "]\n"
+           << "#[Max     = " << std::setw(12) << max() / unitScale << ", Total count    = " << std::setw(12) << count()
+           << "]\n";
+    stream.flags(flags);
+}
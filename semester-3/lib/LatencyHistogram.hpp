@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// HDR-style histogram: values are grouped into power-of-two buckets, each
+// split into enough linear sub-buckets to keep `significantDigits` decimal
+// digits of precision. Memory stays fixed (a few hundred KiB for an hour
+// in microseconds at 3 digits) no matter how many values are recorded, and
+// recording is a couple of shifts and an increment.
+class LatencyHistogram
+{
+  private:
+    uint64_t highestTrackable;
+    int subBucketHalfCountMagnitude;
+    uint64_t subBucketHalfCount;
+    uint64_t subBucketMask;
+    std::vector<uint64_t> counts;
+
+    uint64_t total = 0;
+    uint64_t minimum = UINT64_MAX;
+    uint64_t maximum = 0;
+    double sum = 0, sumOfSquares = 0;
+
+    size_t indexOf(uint64_t value) const;
+    uint64_t lowestAt(size_t index) const;
+    uint64_t highestAt(size_t index) const;
+
+  public:
+    LatencyHistogram(uint64_t highestTrackable = 3'600'000'000, int significantDigits = 3);
+
+    void record(uint64_t value, uint64_t count = 1);
+    void merge(const LatencyHistogram &other);
+    void reset();
+
+    uint64_t count() const;
+    uint64_t min() const;
+    uint64_t max() const;
+    double mean() const;
+    double stddev() const;
+    // `percentile` is in [0, 100]
+    uint64_t valueAt(double percentile) const;
+
+    // Prints the percentile distribution in the HdrHistogram text format,
+    // with values divided by `unitScale`
+    void print(std::ostream &stream, double unitScale = 1, int ticksPerHalfDistance = 5) const;
+};
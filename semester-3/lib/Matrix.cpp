@@ -23,8 +23,8 @@ std::string Matrix::toString() const
 
 std::ostream &operator<<(std::ostream &stream, const Matrix &matrix)
 {
-    for (int i = 0, m = matrix.getWidth(); i < m; i++) {
-        for (int j = 0, n = matrix.getHeight(); j < n; j++) {
+    for (int i = 0, m = matrix.getHeight(); i < m; i++) {
+        for (int j = 0, n = matrix.getWidth(); j < n; j++) {
             stream << matrix(i, j) << ' ';
         }
         stream << '\n';
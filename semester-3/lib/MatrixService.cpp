@@ -0,0 +1,171 @@
+#include "MatrixService.hpp"
+#include "DenseMatrix.hpp"
+#include "SparseMatrix.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+static const std::string BINARY_CONTENT_TYPE = "application/octet-stream";
+
+static std::map<std::string, std::string> getMatrixResponseHeaders(const Matrix &matrix, bool binary)
+{
+    if (!binary) {
+        return {{"Content-Type", "text/plain"}};
+    }
+
+    size_t size = 2 * sizeof(uint32_t) + sizeof(double) * matrix.getHeight() * matrix.getWidth();
+    return {{"Content-Length", std::to_string(size)}, {"Content-Type", BINARY_CONTENT_TYPE}};
+}
+
+MatrixResponse::MatrixResponse(std::unique_ptr<Matrix> matrix, bool binary)
+    : Response(getMatrixResponseHeaders(*matrix, binary)), matrix(std::move(matrix)), binary(binary)
+{
+}
+
+std::ostream &MatrixResponse::writeBody(std::ostream &stream) const
+{
+    if (!binary) {
+        // Enough digits for the values to read back unchanged
+        std::streamsize precision = stream.precision(std::numeric_limits<double>::max_digits10);
+        stream << *matrix;
+        stream.precision(precision);
+        return stream;
+    }
+
+    uint32_t size[2] = {static_cast<uint32_t>(matrix->getHeight()), static_cast<uint32_t>(matrix->getWidth())};
+    stream.write(reinterpret_cast<const char *>(size), sizeof(size));
+
+    std::vector<double> row(matrix->getWidth());
+    for (int i = 0, m = matrix->getHeight(); i < m && stream; i++) {
+        for (int j = 0, n = matrix->getWidth(); j < n; j++) {
+            row[j] = (*matrix)(i, j);
+        }
+        stream.write(reinterpret_cast<const char *>(row.data()), row.size() * sizeof(double));
+    }
+    return stream;
+}
+
+// Value of `name` in the query string of `path`, or "" if there is none
+static std::string getQueryParameter(const std::string &path, const std::string &name)
+{
+    size_t start = path.find('?');
+    while (start != std::string::npos) {
+        start++;
+        size_t end = std::min(path.find('&', start), path.size());
+        if (!path.compare(start, name.size() + 1, name + '=')) {
+            return path.substr(start + name.size() + 1, end - start - name.size() - 1);
+        }
+        start = path.find('&', start);
+    }
+    return "";
+}
+
+static bool isSparse(const std::string &representation)
+{
+    if (representation.empty() || representation == "dense") {
+        return false;
+    }
+    if (representation == "sparse") {
+        return true;
+    }
+    throw BadRequestError();
+}
+
+static std::unique_ptr<Matrix> readTextMatrix(const std::string &text, bool sparse)
+{
+    if (sparse) {
+        return std::unique_ptr<Matrix>(new SparseMatrix(std::istringstream(text)));
+    }
+    return std::unique_ptr<Matrix>(new DenseMatrix(std::istringstream(text)));
+}
+
+// Reads one operand off the front of `data`
+static std::unique_ptr<Matrix> readBinaryMatrix(std::string_view &data, bool sparse)
+{
+    uint32_t size[2];
+    if (data.size() < sizeof(size)) {
+        throw BadRequestError();
+    }
+    std::memcpy(size, data.data(), sizeof(size));
+    data.remove_prefix(sizeof(size));
+
+    uint32_t height = size[0], width = size[1];
+    if (!height || !width || height > INT_MAX || width > INT_MAX ||
+        static_cast<uint64_t>(height) * width > data.size() / sizeof(double)) {
+        throw BadRequestError();
+    }
+
+    std::unique_ptr<DenseMatrix> matrix(new DenseMatrix(height, width));
+    for (uint32_t i = 0; i < height; i++) {
+        std::memcpy(&(*matrix)(i, 0), data.data(), width * sizeof(double));
+        data.remove_prefix(width * sizeof(double));
+    }
+
+    if (sparse) {
+        return std::unique_ptr<Matrix>(new SparseMatrix(*matrix));
+    }
+    return matrix;
+}
+
+MatrixService::MatrixService(ComputePool &pool, size_t maxResultElements)
+    : pool(pool), maxResultElements(std::min<size_t>(maxResultElements, INT_MAX))
+{
+}
+
+std::unique_ptr<Response> MatrixService::operator()(const Request &request) const
+{
+    bool sparseA = isSparse(getQueryParameter(request.path, "a"));
+    bool sparseB = isSparse(getQueryParameter(request.path, "b"));
+
+    auto &&contentType = request.headers.find("content-type");
+    bool binary = contentType != request.headers.end() && contentType->second == BINARY_CONTENT_TYPE;
+
+    std::unique_ptr<Matrix> a, b;
+    try {
+        if (binary) {
+            std::string_view data = request.body;
+            a = readBinaryMatrix(data, sparseA);
+            b = readBinaryMatrix(data, sparseB);
+        } else {
+            std::string body = request.body;
+            std::erase(body, '\r');
+
+            size_t separator = body.find("\n\n");
+            if (separator == std::string::npos) {
+                throw BadRequestError();
+            }
+            a = readTextMatrix(body.substr(0, separator), sparseA);
+            b = readTextMatrix(body.substr(separator + 2), sparseB);
+        }
+    } catch (const std::runtime_error &e) {
+        // Malformed matrix
+        throw BadRequestError();
+    } catch (const std::exception &e) {
+        throw InternalServerError();
+    }
+
+    if (a->getWidth() != b->getHeight()) {
+        throw BadRequestError();
+    }
+    if (static_cast<size_t>(a->getHeight()) * static_cast<size_t>(b->getWidth()) > maxResultElements) {
+        throw PayloadTooLargeError();
+    }
+
+    auto product = pool.trySubmit([a = std::move(a), b = std::move(b)] { return a->multiply(*b); });
+    if (!product) {
+        throw ServiceUnavailableError();
+    }
+    try {
+        return std::unique_ptr<Response>(new MatrixResponse(product->get(), binary));
+    } catch (const std::exception &e) {
+        // The multiplication itself failed, e.g. out of memory
+        throw InternalServerError();
+    }
+}
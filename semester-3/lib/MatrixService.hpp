@@ -0,0 +1,49 @@
+#pragma once
+#include "ComputePool.hpp"
+#include "HttpServer.hpp"
+#include "Matrix.hpp"
+
+#include <memory>
+
+// Product of a multiplication, written out a row at a time. In binary the
+// size is known up front; as text the body goes out chunked.
+struct MatrixResponse : public Response {
+  private:
+    std::unique_ptr<Matrix> matrix;
+    bool binary;
+
+  public:
+    MatrixResponse(std::unique_ptr<Matrix> matrix, bool binary);
+
+    virtual std::ostream &writeBody(std::ostream &stream) const override;
+};
+
+// Matrix multiplication over HTTP:
+//
+//     POST /multiply?a=dense&b=sparse
+//
+// The body holds both operands, `a` and `b` telling which representation
+// each should be loaded into (dense by default). With the Content-Type
+// application/octet-stream each operand is its height and width as 32-bit
+// integers followed by its elements as doubles, row by row, in host byte
+// order; otherwise both are in the text format of the matrix files,
+// separated by an empty line. The product comes back in the same format.
+//
+// Multiplications run on a ComputePool rather than on the connection
+// threads; when its queue is full, requests get 503 straight away. The
+// operands are bounded by the body size but their product is not, so
+// products of more than `maxResultElements` elements get 413.
+class MatrixService
+{
+  private:
+    ComputePool &pool;
+    size_t maxResultElements;
+
+  public:
+    // The matrices index their elements with int
+    static constexpr size_t DEFAULT_MAX_RESULT_ELEMENTS = 16 * 1024 * 1024;
+
+    MatrixService(ComputePool &pool, size_t maxResultElements = DEFAULT_MAX_RESULT_ELEMENTS);
+
+    std::unique_ptr<Response> operator()(const Request &request) const;
+};
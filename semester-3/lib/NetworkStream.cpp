@@ -1,35 +1,65 @@
 #include "NetworkStream.hpp"
 #include "AddrInfo.hpp"
+#include "Logging.hpp"
 
 #include <arpa/inet.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <stdlib.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <vector>
 
-NetworkStreamBuffer::NetworkStreamBuffer() : buffer(new char[BUFFER_SIZE])
+NetworkStreamBuffer::NetworkStreamBuffer(size_t inputBufferSize,
+                                         size_t outputBufferSize)
+    : inputBufferSize(inputBufferSize), outputBufferSize(outputBufferSize),
+      inputBuffer(new char[inputBufferSize]),
+      outputBuffer(new char[outputBufferSize])
 {
+    setg(0, 0, 0);
+    setp(outputBuffer, outputBuffer + outputBufferSize);
 }
 
-NetworkStreamBuffer::NetworkStreamBuffer(const char *hostname)
-    : NetworkStreamBuffer()
+NetworkStreamBuffer::NetworkStreamBuffer(const char *hostname,
+                                         const std::string &service,
+                                         size_t inputBufferSize,
+                                         size_t outputBufferSize)
+    : NetworkStreamBuffer(inputBufferSize, outputBufferSize)
 {
-    setg(0, 0, 0);
-    setp(buffer, buffer + BUFFER_SIZE);
-
     const addrinfo hints = {
         .ai_family = AF_UNSPEC,
         .ai_socktype = SOCK_STREAM,
     };
-    const AddrInfo addrInfo(hostname, "http", hints);
+    const AddrInfo addrInfo(hostname, service, hints);
+
+    HTTP_LOG("> Opening socket...");
+    connectTo(addrInfo);
+    HTTP_LOG("> Connected");
+}
 
-    std::cout << "> Opening socket..." << std::endl;
+NetworkStreamBuffer::NetworkStreamBuffer(const AddrInfo &addrInfo,
+                                         size_t inputBufferSize,
+                                         size_t outputBufferSize)
+    : NetworkStreamBuffer(inputBufferSize, outputBufferSize)
+{
+    connectTo(addrInfo);
+}
+
+void NetworkStreamBuffer::connectTo(const AddrInfo &addrInfo)
+{
     socketFileDescriptor = socket(addrInfo.ai_family(), addrInfo.ai_socktype(),
                                   addrInfo.ai_protocol());
 
@@ -41,27 +71,36 @@ NetworkStreamBuffer::NetworkStreamBuffer(const char *hostname)
                 addrInfo.ai_addrlen()) < 0) {
         throw std::runtime_error("Unable to connect");
     }
-    std::cout << "> Connected" << std::endl;
 }
 
-NetworkStreamBuffer::NetworkStreamBuffer(int socketFd) : NetworkStreamBuffer()
+NetworkStreamBuffer::NetworkStreamBuffer(int socketFd, size_t inputBufferSize,
+                                         size_t outputBufferSize)
+    : NetworkStreamBuffer(inputBufferSize, outputBufferSize)
 {
     socketFileDescriptor = socketFd;
 }
 
 NetworkStreamBuffer::~NetworkStreamBuffer()
 {
-    close(socketFileDescriptor);
-    delete[] buffer;
+    if (socketFileDescriptor >= 0) {
+        close(socketFileDescriptor);
+    }
+    delete[] inputBuffer;
+    delete[] outputBuffer;
 }
 
 std::streambuf::int_type NetworkStreamBuffer::underflow()
 {
-    int bytes = recv(socketFileDescriptor, buffer, BUFFER_SIZE, 0);
+    // Output held back for batching must not wait on input that may only
+    // come as a reply to it
+    if (pptr() > pbase() && !writeAll(nullptr, 0)) {
+        return traits_type::eof();
+    }
+
+    int bytes = recv(socketFileDescriptor, inputBuffer, inputBufferSize, 0);
 
     if (bytes < 0) {
-        std::cout << "Unable to receive data: \"" << std::strerror(errno) << '"'
-                  << std::endl;
+        HTTP_LOG("Unable to receive data: \"" << std::strerror(errno) << '"');
         return traits_type::eof();
     }
     if (!bytes) {
@@ -69,34 +108,91 @@ std::streambuf::int_type NetworkStreamBuffer::underflow()
         return traits_type::eof();
     }
 
-    setg(buffer, buffer, buffer + bytes);
+    setg(inputBuffer, inputBuffer, inputBuffer + bytes);
     return traits_type::to_int_type(*gptr());
 }
 
-std::streambuf::int_type
-NetworkStreamBuffer::overflow(std::streambuf::int_type value)
+bool NetworkStreamBuffer::writeAll(const iovec *parts, int count, bool more)
 {
-    auto *from = pbase();
-    int amount = pptr() - pbase();
-    while (amount) {
-        int written = send(socketFileDescriptor, from, amount, MSG_NOSIGNAL);
+    constexpr int LOCAL_PARTS = 16;
+    iovec localParts[LOCAL_PARTS];
+    std::vector<iovec> heapParts;
+
+    iovec *iov = localParts;
+    if (count + 1 > LOCAL_PARTS) {
+        heapParts.resize(count + 1);
+        iov = heapParts.data();
+    }
+
+    size_t left = 0;
+    if (pptr() > pbase()) {
+        iov[left++] = {pbase(), static_cast<size_t>(pptr() - pbase())};
+    }
+    for (int i = 0; i < count; i++) {
+        if (parts[i].iov_len) iov[left++] = parts[i];
+    }
+    setp(outputBuffer, outputBuffer + outputBufferSize);
+
+    const int flags = MSG_NOSIGNAL | (more ? MSG_MORE : 0);
+    while (left) {
+        msghdr message {};
+        message.msg_iov = iov;
+        message.msg_iovlen = std::min<size_t>(left, IOV_MAX);
+
+        ssize_t written = sendmsg(socketFileDescriptor, &message, flags);
         if (written < 0) {
-            if (errno == EPIPE) {
+            if (errno == EINTR) continue;
+            if (errno == EPIPE || errno == ECONNRESET) {
                 disconnected = true;
             }
-            return traits_type::eof();
+            return false;
+        }
+
+        while (left && static_cast<size_t>(written) >= iov->iov_len) {
+            written -= iov->iov_len;
+            ++iov;
+            --left;
+        }
+        if (left) {
+            iov->iov_base = static_cast<char *>(iov->iov_base) + written;
+            iov->iov_len -= written;
         }
+    }
+    return true;
+}
 
-        from += written;
-        amount -= written;
+std::streambuf::int_type
+NetworkStreamBuffer::overflow(std::streambuf::int_type value)
+{
+    if (!writeAll(nullptr, 0)) {
+        return traits_type::eof();
     }
 
-    setp(buffer, buffer + BUFFER_SIZE);
     if (!traits_type::eq_int_type(value, traits_type::eof()))
         sputc(value);
     return traits_type::not_eof(value);
 }
 
+std::streamsize NetworkStreamBuffer::xsputn(const char *data,
+                                            std::streamsize count)
+{
+    std::streamsize available = epptr() - pptr();
+    if (count <= available) {
+        std::memcpy(pptr(), data, count);
+        pbump(count);
+        return count;
+    }
+
+    // Small writes keep filling the buffer; large ones (response bodies)
+    // are sent together with what is already buffered in one sendmsg().
+    if (static_cast<size_t>(count) < outputBufferSize / 4) {
+        return std::streambuf::xsputn(data, count);
+    }
+
+    iovec part = {const_cast<char *>(data), static_cast<size_t>(count)};
+    return writeAll(&part, 1) ? count : 0;
+}
+
 int NetworkStreamBuffer::sync()
 {
     std::streambuf::int_type result = this->overflow(traits_type::eof());
@@ -112,13 +208,24 @@ std::ostream &net::endrequest(std::ostream &stream)
     return stream << "\r\n\r\n";
 }
 
-NetworkStream::NetworkStream(const char *hostname)
-    : std::iostream(new NetworkStreamBuffer(hostname))
+NetworkStream::NetworkStream(const char *hostname, const std::string &service,
+                             size_t inputBufferSize, size_t outputBufferSize)
+    : std::iostream(new NetworkStreamBuffer(hostname, service, inputBufferSize,
+                                            outputBufferSize))
 {
 }
 
-NetworkStream::NetworkStream(int socketFd)
-    : std::iostream(new NetworkStreamBuffer(socketFd))
+NetworkStream::NetworkStream(const AddrInfo &addrInfo, size_t inputBufferSize,
+                             size_t outputBufferSize)
+    : std::iostream(new NetworkStreamBuffer(addrInfo, inputBufferSize,
+                                            outputBufferSize))
+{
+}
+
+NetworkStream::NetworkStream(int socketFd, size_t inputBufferSize,
+                             size_t outputBufferSize)
+    : std::iostream(new NetworkStreamBuffer(socketFd, inputBufferSize,
+                                            outputBufferSize))
 {
 }
 
@@ -135,4 +242,79 @@ int NetworkStream::socket()
 bool NetworkStream::disconnected()
 {
     return dynamic_cast<NetworkStreamBuffer *>(rdbuf())->disconnected;
+}
+
+NetworkStream &NetworkStream::writev(const iovec *parts, int count)
+{
+    auto *buffer = dynamic_cast<NetworkStreamBuffer *>(rdbuf());
+    if (!buffer->writeAll(parts, count)) {
+        setstate(std::ios::badbit);
+    }
+    return *this;
+}
+
+NetworkStream &NetworkStream::flushMore()
+{
+    auto *buffer = dynamic_cast<NetworkStreamBuffer *>(rdbuf());
+    if (!buffer->writeAll(nullptr, 0, true)) {
+        setstate(std::ios::badbit);
+    }
+    return *this;
+}
+
+NetworkStream &NetworkStream::cork(bool enabled)
+{
+    int value = enabled;
+    // Not a TCP socket (e.g. a socketpair): corking is just an optimization
+    setsockopt(socket(), IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+    return *this;
+}
+
+NetworkStream &NetworkStream::sendFile(const std::filesystem::path &path)
+{
+    int fileFd = open(path.c_str(), O_RDONLY);
+    if (fileFd < 0) {
+        setstate(std::ios::failbit);
+        return *this;
+    }
+
+    struct stat info;
+    if (fstat(fileFd, &info) < 0) {
+        close(fileFd);
+        setstate(std::ios::failbit);
+        return *this;
+    }
+
+    // A small file costs one read() when copied into the output buffer,
+    // and then leaves together with whatever else is buffered, instead of
+    // taking four syscalls of its own
+    auto *buffer = dynamic_cast<NetworkStreamBuffer *>(rdbuf());
+    if (static_cast<size_t>(info.st_size) < buffer->outputBufferSize / 4 &&
+        info.st_size <= buffer->epptr() - buffer->pptr()) {
+        ssize_t bytes = ::read(fileFd, buffer->pptr(), info.st_size);
+        close(fileFd);
+        if (bytes != info.st_size) {
+            setstate(std::ios::badbit);
+            return *this;
+        }
+        buffer->pbump(bytes);
+        return *this;
+    }
+
+    cork(true);
+    flushMore();
+
+    off_t offset = 0;
+    while (good() && offset < info.st_size) {
+        ssize_t sent =
+            ::sendfile(socket(), fileFd, &offset, info.st_size - offset);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) {
+            setstate(std::ios::badbit);
+        }
+    }
+
+    close(fileFd);
+    cork(false);
+    return *this;
 }
\ No newline at end of file
@@ -1,10 +1,16 @@
 #pragma once
+#include <sys/uio.h>
+
+#include <filesystem>
 #include <fstream>
 #include <functional>
+#include <string>
 
-constexpr int BUFFER_SIZE = 1024;
+constexpr size_t DEFAULT_INPUT_BUFFER_SIZE = 16 * 1024;
+constexpr size_t DEFAULT_OUTPUT_BUFFER_SIZE = 64 * 1024;
 
 class NetworkStream;
+struct AddrInfo;
 
 namespace net
 {
@@ -16,18 +22,36 @@ class NetworkStreamBuffer : public std::streambuf
 {
   private:
     bool disconnected = false;
-    int socketFileDescriptor;
-    char *buffer;
+    // -1 until connected, so that a constructor that throws closes nothing
+    int socketFileDescriptor = -1;
+    size_t inputBufferSize, outputBufferSize;
+    char *inputBuffer;
+    char *outputBuffer;
+
+    NetworkStreamBuffer(size_t inputBufferSize, size_t outputBufferSize);
 
-    NetworkStreamBuffer();
+    // Sends buffered output followed by `parts` using as few syscalls as
+    // possible. Returns false if the peer is gone or send failed.
+    bool writeAll(const iovec *parts, int count, bool more = false);
+
+    void connectTo(const AddrInfo &addrInfo);
 
   public:
-    NetworkStreamBuffer(const char *hostname);
-    NetworkStreamBuffer(int socketFd);
+    NetworkStreamBuffer(const char *hostname,
+                        const std::string &service = "http",
+                        size_t inputBufferSize = DEFAULT_INPUT_BUFFER_SIZE,
+                        size_t outputBufferSize = DEFAULT_OUTPUT_BUFFER_SIZE);
+    NetworkStreamBuffer(const AddrInfo &addrInfo,
+                        size_t inputBufferSize = DEFAULT_INPUT_BUFFER_SIZE,
+                        size_t outputBufferSize = DEFAULT_OUTPUT_BUFFER_SIZE);
+    NetworkStreamBuffer(int socketFd,
+                        size_t inputBufferSize = DEFAULT_INPUT_BUFFER_SIZE,
+                        size_t outputBufferSize = DEFAULT_OUTPUT_BUFFER_SIZE);
     ~NetworkStreamBuffer();
 
     virtual std::streambuf::int_type underflow();
     virtual std::streambuf::int_type overflow(std::streambuf::int_type value);
+    virtual std::streamsize xsputn(const char *data, std::streamsize count);
     virtual int sync();
 
     friend class NetworkStream;
@@ -36,10 +60,36 @@ class NetworkStreamBuffer : public std::streambuf
 class NetworkStream : public std::iostream
 {
   public:
-    NetworkStream(const char *hostname);
-    NetworkStream(int socketFd);
+    NetworkStream(const char *hostname, const std::string &service = "http",
+                  size_t inputBufferSize = DEFAULT_INPUT_BUFFER_SIZE,
+                  size_t outputBufferSize = DEFAULT_OUTPUT_BUFFER_SIZE);
+    // Connects to an already resolved address (see AddrInfoCache)
+    NetworkStream(const AddrInfo &addrInfo,
+                  size_t inputBufferSize = DEFAULT_INPUT_BUFFER_SIZE,
+                  size_t outputBufferSize = DEFAULT_OUTPUT_BUFFER_SIZE);
+    NetworkStream(int socketFd,
+                  size_t inputBufferSize = DEFAULT_INPUT_BUFFER_SIZE,
+                  size_t outputBufferSize = DEFAULT_OUTPUT_BUFFER_SIZE);
     virtual ~NetworkStream();
 
     bool disconnected();
     int socket();
+
+    // Scatter/gather write: whatever is buffered goes out together with
+    // `parts` in a single writev() where the kernel accepts it.
+    NetworkStream &writev(const iovec *parts, int count);
+
+    // Flushes buffered output with MSG_MORE, telling the kernel that more
+    // data (e.g. a sendfile() body) follows immediately.
+    NetworkStream &flushMore();
+
+    // Toggles TCP_CORK: while corked, partial frames are held back until
+    // uncorked or a full segment accumulates.
+    NetworkStream &cork(bool enabled);
+
+    // Writes buffered headers and then the file contents via sendfile(),
+    // corking the socket so both leave in as few segments as possible.
+    // Small files are copied into the output buffer instead and sent with
+    // the next flush.
+    NetworkStream &sendFile(const std::filesystem::path &path);
 };
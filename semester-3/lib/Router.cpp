@@ -0,0 +1,105 @@
+#include "Router.hpp"
+#include <algorithm>
+
+int Router::child(int node, char c) const
+{
+    const auto &children = m_nodes[node].children;
+    auto it = std::lower_bound(children.begin(), children.end(), c, [](const std::pair<char, int> &child, char c) {
+        return child.first < c;
+    });
+    return it != children.end() && it->first == c ? it->second : -1;
+}
+
+Router &Router::route(const std::string &method, const std::string &pattern, RequestHandler handler)
+{
+    if (pattern.empty() || pattern[0] != '/') {
+        throw std::runtime_error("Route pattern must start with '/': \"" + pattern + '"');
+    }
+
+    bool isPrefix = pattern.back() == '*';
+    std::string_view path(pattern.data(), pattern.size() - isPrefix);
+
+    int node = 0;
+    for (char c : path) {
+        int next = child(node, c);
+        if (next < 0) {
+            next = m_nodes.size();
+            m_nodes.emplace_back();
+
+            auto &children = m_nodes[node].children;
+            children.insert(
+                std::upper_bound(
+                    children.begin(),
+                    children.end(),
+                    c,
+                    [](char c, const std::pair<char, int> &child) {
+                        return c < child.first;
+                    }
+                ),
+                {c, next}
+            );
+        }
+        node = next;
+    }
+
+    auto &routes = isPrefix ? m_nodes[node].prefix : m_nodes[node].exact;
+    routes.push_back({method, std::move(handler)});
+    return *this;
+}
+
+Router &Router::get(const std::string &pattern, RequestHandler handler)
+{
+    return route("GET", pattern, std::move(handler));
+}
+
+Router &Router::post(const std::string &pattern, RequestHandler handler)
+{
+    return route("POST", pattern, std::move(handler));
+}
+
+const RequestHandler *Router::find(const std::vector<Route> &routes, const std::string &method, bool &pathMatched)
+{
+    for (auto &&route : routes) {
+        pathMatched = true;
+        if (route.method == method) {
+            return &route.handler;
+        }
+    }
+    return nullptr;
+}
+
+const RequestHandler &Router::resolve(const Request &request) const
+{
+    std::string_view path = request.path;
+    path = path.substr(0, path.find('?'));
+
+    bool pathMatched = false;
+    const RequestHandler *handler = nullptr;
+
+    int node = 0;
+    for (size_t i = 0; node >= 0; i++) {
+        if (auto *h = find(m_nodes[node].prefix, request.method, pathMatched)) {
+            handler = h;
+        }
+        if (i == path.size()) {
+            if (auto *h = find(m_nodes[node].exact, request.method, pathMatched)) {
+                return *h;
+            }
+            break;
+        }
+        node = child(node, path[i]);
+    }
+
+    if (handler) {
+        return *handler;
+    }
+    if (pathMatched) {
+        throw MethodNotAllowedError();
+    }
+    throw NotFoundError();
+}
+
+std::unique_ptr<Response> Router::operator()(const Request &request) const
+{
+    return resolve(request)(request);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "HttpServer.hpp"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Routing table compiled into a flat character trie. A lookup walks the
+// request path once, so dispatch costs O(path length) and never allocates.
+//
+// Patterns are either exact ("/metrics") or prefixes ending with '*'
+// ("/assets/*"); exact matches win, otherwise the longest prefix does.
+class Router
+{
+  private:
+    struct Route {
+        std::string method;
+        RequestHandler handler;
+    };
+
+    struct Node {
+        std::vector<std::pair<char, int>> children;
+        std::vector<Route> exact;
+        std::vector<Route> prefix;
+    };
+
+    std::vector<Node> m_nodes {Node()};
+
+    int child(int node, char c) const;
+    static const RequestHandler *find(const std::vector<Route> &routes, const std::string &method, bool &pathMatched);
+
+  public:
+    Router &route(const std::string &method, const std::string &pattern, RequestHandler handler);
+    Router &get(const std::string &pattern, RequestHandler handler);
+    Router &post(const std::string &pattern, RequestHandler handler);
+
+    // Returns the handler for the request or throws NotFoundError /
+    // MethodNotAllowedError when nothing matches.
+    const RequestHandler &resolve(const Request &request) const;
+
+    std::unique_ptr<Response> operator()(const Request &request) const;
+};
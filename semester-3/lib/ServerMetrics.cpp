@@ -0,0 +1,147 @@
+#include "ServerMetrics.hpp"
+#include <algorithm>
+#include <sstream>
+
+static const char *PHASE_NAMES[ServerMetrics::PHASE_COUNT] = {"accept", "parse", "handler", "write"};
+
+ServerMetrics::Shard *ServerMetrics::acquire()
+{
+    std::lock_guard lock(mutex);
+    if (!freeShards.empty()) {
+        Shard *shard = freeShards.back();
+        freeShards.pop_back();
+        return shard;
+    }
+
+    shards.push_back(std::make_unique<Shard>());
+    return shards.back().get();
+}
+
+void ServerMetrics::release(Shard *shard)
+{
+    std::lock_guard lock(mutex);
+    freeShards.push_back(shard);
+}
+
+ServerMetrics::Recorder ServerMetrics::recorder()
+{
+    return Recorder(this);
+}
+
+ServerMetrics::Recorder::Recorder(ServerMetrics *metrics) : metrics(metrics)
+{
+    if (metrics) {
+        shard = metrics->acquire();
+        shard->connections.add();
+        metrics->activeConnections.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+ServerMetrics::Recorder::Recorder(Recorder &&recorder)
+    : metrics(recorder.metrics), shard(recorder.shard), mark(recorder.mark)
+{
+    recorder.metrics = nullptr;
+    recorder.shard = nullptr;
+}
+
+ServerMetrics::Recorder::~Recorder()
+{
+    if (shard) {
+        metrics->activeConnections.fetch_sub(1, std::memory_order_relaxed);
+        metrics->release(shard);
+    }
+}
+
+void ServerMetrics::Recorder::start(Clock::time_point from)
+{
+    if (shard) {
+        mark = from;
+    }
+}
+
+void ServerMetrics::Recorder::lap(Phase phase)
+{
+    if (!shard) {
+        return;
+    }
+
+    Clock::time_point now = Clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - mark);
+    mark = now;
+
+    Histogram &histogram = shard->phases[static_cast<size_t>(phase)];
+    size_t bucket = std::lower_bound(BUCKET_BOUNDS.begin(), BUCKET_BOUNDS.end(), elapsed) - BUCKET_BOUNDS.begin();
+    histogram.buckets[bucket].add();
+    histogram.sumNanoseconds.add(elapsed.count());
+}
+
+void ServerMetrics::Recorder::countResponse(int status)
+{
+    if (shard && status >= 100 && status < 600) {
+        shard->responses[status / 100 - 1].add();
+    }
+}
+
+void ServerMetrics::write(std::ostream &stream)
+{
+    uint64_t connections = 0;
+    std::array<uint64_t, 5> responses {};
+    std::array<std::array<uint64_t, BUCKET_BOUNDS.size() + 1>, PHASE_COUNT> buckets {};
+    std::array<uint64_t, PHASE_COUNT> sums {};
+
+    {
+        std::lock_guard lock(mutex);
+        for (auto &&shard : shards) {
+            connections += shard->connections.get();
+            for (size_t i = 0; i < responses.size(); i++) {
+                responses[i] += shard->responses[i].get();
+            }
+            for (size_t phase = 0; phase < PHASE_COUNT; phase++) {
+                const Histogram &histogram = shard->phases[phase];
+                for (size_t i = 0; i < histogram.buckets.size(); i++) {
+                    buckets[phase][i] += histogram.buckets[i].get();
+                }
+                sums[phase] += histogram.sumNanoseconds.get();
+            }
+        }
+    }
+
+    stream << "# HELP http_server_connections_active Connections currently open.\n"
+           << "# TYPE http_server_connections_active gauge\n"
+           << "http_server_connections_active " << activeConnections.load(std::memory_order_relaxed) << '\n';
+
+    stream << "# HELP http_server_connections_total Connections accepted.\n"
+           << "# TYPE http_server_connections_total counter\n"
+           << "http_server_connections_total " << connections << '\n';
+
+    stream << "# HELP http_server_responses_total Responses sent, by status class.\n"
+           << "# TYPE http_server_responses_total counter\n";
+    for (size_t i = 0; i < responses.size(); i++) {
+        stream << "http_server_responses_total{code=\"" << i + 1 << "xx\"} " << responses[i] << '\n';
+    }
+
+    stream << "# HELP http_server_phase_duration_seconds Time spent in each phase of serving a request.\n"
+           << "# TYPE http_server_phase_duration_seconds histogram\n";
+    for (size_t phase = 0; phase < PHASE_COUNT; phase++) {
+        std::string labels = std::string("phase=\"") + PHASE_NAMES[phase] + '"';
+
+        // Prometheus buckets are cumulative
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < BUCKET_BOUNDS.size(); i++) {
+            cumulative += buckets[phase][i];
+            stream << "http_server_phase_duration_seconds_bucket{" << labels << ",le=\""
+                   << std::chrono::duration<double>(BUCKET_BOUNDS[i]).count() << "\"} " << cumulative << '\n';
+        }
+        cumulative += buckets[phase].back();
+        stream << "http_server_phase_duration_seconds_bucket{" << labels << ",le=\"+Inf\"} " << cumulative << '\n'
+               << "http_server_phase_duration_seconds_sum{" << labels << "} " << sums[phase] / 1e9 << '\n'
+               << "http_server_phase_duration_seconds_count{" << labels << "} " << cumulative << '\n';
+    }
+}
+
+std::string ServerMetrics::render()
+{
+    std::ostringstream stream;
+    write(stream);
+    return stream.str();
+}
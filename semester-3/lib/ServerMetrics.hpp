@@ -0,0 +1,121 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Request counters and per-phase latency histograms for a server, exported
+// in the Prometheus text format.
+//
+// Recording never takes a lock: every connection records into a shard of
+// its own, which only that connection writes to. Shards are handed out
+// when a connection opens and recycled (counts included) when it closes;
+// export sums them all up. Must outlive the connections recording into it.
+class ServerMetrics
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Phase {
+        // From accept() returning to the connection being ready to read
+        Accept,
+        // From the first byte of a request to the end of its body
+        Parse,
+        Handler,
+        Write,
+    };
+    static constexpr size_t PHASE_COUNT = 4;
+
+    // Upper bounds of the histogram buckets
+    static constexpr std::array<std::chrono::nanoseconds, 16> BUCKET_BOUNDS = {
+        std::chrono::microseconds(10),  std::chrono::microseconds(25),  std::chrono::microseconds(50),
+        std::chrono::microseconds(100), std::chrono::microseconds(250), std::chrono::microseconds(500),
+        std::chrono::milliseconds(1),   std::chrono::milliseconds(2),   std::chrono::milliseconds(5),
+        std::chrono::milliseconds(10),  std::chrono::milliseconds(25),  std::chrono::milliseconds(50),
+        std::chrono::milliseconds(100), std::chrono::milliseconds(250), std::chrono::milliseconds(500),
+        std::chrono::seconds(1),
+    };
+
+    static constexpr const char *CONTENT_TYPE = "text/plain; version=0.0.4";
+
+  private:
+    // Only ever written by one thread, so a relaxed load and store does
+    // instead of a locked read-modify-write; readers may lag slightly
+    class Counter
+    {
+      private:
+        std::atomic<uint64_t> value {0};
+
+      public:
+        void add(uint64_t amount = 1)
+        {
+            value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+        uint64_t get() const
+        {
+            return value.load(std::memory_order_relaxed);
+        }
+    };
+
+    struct Histogram {
+        // The last bucket counts everything above the largest bound
+        std::array<Counter, BUCKET_BOUNDS.size() + 1> buckets;
+        Counter sumNanoseconds;
+    };
+
+    // Cache-line aligned so that shards in use by different threads never
+    // share a line
+    struct alignas(64) Shard {
+        Counter connections;
+        // Indexed by status / 100 - 1
+        std::array<Counter, 5> responses;
+        std::array<Histogram, PHASE_COUNT> phases;
+    };
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<Shard *> freeShards;
+    std::atomic<int64_t> activeConnections {0};
+
+    Shard *acquire();
+    void release(Shard *shard);
+
+  public:
+    ServerMetrics() = default;
+    ServerMetrics(const ServerMetrics &) = delete;
+    ServerMetrics &operator=(const ServerMetrics &) = delete;
+
+    // Records the metrics of one connection. A recorder made without a
+    // ServerMetrics does nothing, so instrumented code needs no checks.
+    class Recorder
+    {
+      private:
+        ServerMetrics *metrics = nullptr;
+        Shard *shard = nullptr;
+        Clock::time_point mark;
+
+      public:
+        Recorder() = default;
+        Recorder(ServerMetrics *metrics);
+        Recorder(Recorder &&recorder);
+        Recorder &operator=(Recorder &&recorder) = delete;
+        ~Recorder();
+
+        // Starts timing the next phase
+        void start(Clock::time_point from = Clock::now());
+        // Records the time since the previous start() or lap() for `phase`
+        // and starts timing the next one
+        void lap(Phase phase);
+        void countResponse(int status);
+    };
+
+    Recorder recorder();
+
+    void write(std::ostream &stream);
+    std::string render();
+};
@@ -61,6 +61,20 @@ SparseMatrix::SparseMatrix(std::istream &&stream)
     initFromMap(values);
 }
 
+SparseMatrix::SparseMatrix(const DenseMatrix &matrix) : m_width(matrix.getWidth()), m_height(matrix.getHeight())
+{
+    m_rows.reserve(m_height + 1);
+    for (int i = 0; i < m_height; i++) {
+        for (int j = 0; j < m_width; j++) {
+            if (matrix(i, j)) {
+                m_values.push_back(matrix(i, j));
+                m_cols.push_back(j);
+            }
+        }
+        m_rows.push_back(m_values.size());
+    }
+}
+
 SparseMatrix::SparseMatrix(int height, int width, const std::map<std::pair<int, int>, matrix_element_t> &values)
     : m_width(width), m_height(height)
 {
@@ -110,7 +124,7 @@ void SparseMatrix::multiply(const DenseMatrix &m, int from, int to, DenseMatrix
 {
     for (int r = from; r < to; r++) {
         for (int i = m_rows[r], l = m_rows[r + 1]; i < l; i++) {
-            for (int j = 0; j < m_width; j++) {
+            for (int j = 0, n = m.getWidth(); j < n; j++) {
                 result(r, j) += m_values[i] * m(m_cols[i], j);
             }
         }
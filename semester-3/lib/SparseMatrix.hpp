@@ -27,6 +27,8 @@ class SparseMatrix : public Matrix
     SparseMatrix(int height, int width);
     SparseMatrix(const std::string &filename);
     SparseMatrix(std::istream &&stream);
+    // Keeps the non-zero elements of `matrix`
+    explicit SparseMatrix(const DenseMatrix &matrix);
 
     virtual const matrix_element_t operator()(int i, int j) const override;
 
@@ -0,0 +1,164 @@
+#pragma once
+#include "Logging.hpp"
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+template <typename T> class Task;
+
+namespace detail
+{
+    struct TaskPromiseBase {
+        std::coroutine_handle<> continuation;
+        std::exception_ptr exception;
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept
+            {
+                return false;
+            }
+            template <typename Promise> std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+            {
+                auto continuation = handle.promise().continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+            void await_resume() noexcept
+            {
+            }
+        };
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+        FinalAwaiter final_suspend() noexcept
+        {
+            return {};
+        }
+        void unhandled_exception()
+        {
+            exception = std::current_exception();
+        }
+    };
+
+    template <typename T> struct TaskPromise : TaskPromiseBase {
+        std::optional<T> value;
+
+        Task<T> get_return_object();
+        void return_value(T result)
+        {
+            value.emplace(std::move(result));
+        }
+        T result()
+        {
+            if (exception) std::rethrow_exception(exception);
+            return std::move(*value);
+        }
+    };
+
+    template <> struct TaskPromise<void> : TaskPromiseBase {
+        Task<void> get_return_object();
+        void return_void()
+        {
+        }
+        void result()
+        {
+            if (exception) std::rethrow_exception(exception);
+        }
+    };
+} // namespace detail
+
+// Lazily started coroutine; awaiting it runs the body and resumes the
+// awaiting coroutine (via symmetric transfer) once the body finishes.
+template <typename T = void> class [[nodiscard]] Task
+{
+  public:
+    using promise_type = detail::TaskPromise<T>;
+
+  private:
+    std::coroutine_handle<promise_type> m_handle;
+
+  public:
+    explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle)
+    {
+    }
+    Task(Task &&task) noexcept : m_handle(std::exchange(task.m_handle, nullptr))
+    {
+    }
+    Task &operator=(Task &&task) noexcept
+    {
+        if (this != &task) {
+            if (m_handle) m_handle.destroy();
+            m_handle = std::exchange(task.m_handle, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+    ~Task()
+    {
+        if (m_handle) m_handle.destroy();
+    }
+
+    bool await_ready() const noexcept
+    {
+        return !m_handle || m_handle.done();
+    }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_handle.promise().continuation = awaiting;
+        return m_handle;
+    }
+    T await_resume()
+    {
+        return m_handle.promise().result();
+    }
+};
+
+namespace detail
+{
+    template <typename T> Task<T> TaskPromise<T>::get_return_object()
+    {
+        return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+    }
+    inline Task<void> TaskPromise<void>::get_return_object()
+    {
+        return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+    }
+
+    // Fire-and-forget coroutine frame that owns a Task and frees itself
+    struct Detached {
+        struct promise_type {
+            Detached get_return_object() noexcept
+            {
+                return {};
+            }
+            std::suspend_never initial_suspend() noexcept
+            {
+                return {};
+            }
+            std::suspend_never final_suspend() noexcept
+            {
+                return {};
+            }
+            void return_void() noexcept
+            {
+            }
+            void unhandled_exception() noexcept
+            {
+            }
+        };
+    };
+} // namespace detail
+
+// Starts the task immediately; it keeps running on the event loop after the
+// caller returns. Exceptions escaping the task are reported and swallowed.
+inline detail::Detached spawn(Task<void> task)
+{
+    try {
+        co_await task;
+    } catch (const std::exception &e) {
+        HTTP_LOG("> Detached task failed: \"" << e.what() << '"');
+    }
+}
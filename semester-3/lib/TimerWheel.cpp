@@ -0,0 +1,94 @@
+#include "TimerWheel.hpp"
+#include <sys/socket.h>
+
+#include <algorithm>
+
+TimerWheel::TimerWheel(Clock::duration tick, size_t slotCount) : tick(tick), slots(slotCount)
+{
+    thread = std::thread(&TimerWheel::run, this);
+}
+
+TimerWheel::~TimerWheel()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopped = true;
+    }
+    stopping.notify_one();
+    thread.join();
+}
+
+TimerWheel::TimerId TimerWheel::schedule(Clock::duration timeout, Callback callback)
+{
+    // Round up, so a timer never fires early
+    size_t ticks = std::max<size_t>(1, (timeout + tick - Clock::duration(1)) / tick);
+
+    std::lock_guard lock(mutex);
+    size_t slot = (cursor + ticks) % slots.size();
+    TimerId id = nextId++;
+
+    auto &&bucket = slots[slot];
+    bucket.push_front({id, (ticks - 1) / slots.size(), std::move(callback)});
+    timers[id] = {slot, bucket.begin()};
+    return id;
+}
+
+bool TimerWheel::cancel(TimerId id)
+{
+    std::lock_guard lock(mutex);
+    auto &&it = timers.find(id);
+    if (it == timers.end()) {
+        return false;
+    }
+
+    slots[it->second.slot].erase(it->second.timer);
+    timers.erase(it);
+    return true;
+}
+
+void TimerWheel::run()
+{
+    auto next = Clock::now() + tick;
+
+    std::unique_lock lock(mutex);
+    while (!stopping.wait_until(lock, next, [this] { return stopped; })) {
+        next += tick;
+        cursor = (cursor + 1) % slots.size();
+
+        auto &&bucket = slots[cursor];
+        for (auto it = bucket.begin(); it != bucket.end();) {
+            if (it->rounds) {
+                it->rounds--;
+                ++it;
+                continue;
+            }
+
+            it->callback();
+            timers.erase(it->id);
+            it = bucket.erase(it);
+        }
+    }
+}
+
+SocketDeadline::SocketDeadline(TimerWheel &timers, int socketFd) : timers(timers), socketFd(socketFd)
+{
+}
+
+SocketDeadline::~SocketDeadline()
+{
+    cancel();
+}
+
+void SocketDeadline::set(TimerWheel::Clock::duration timeout)
+{
+    cancel();
+    timer = timers.schedule(timeout, [socketFd = socketFd] { shutdown(socketFd, SHUT_RDWR); });
+}
+
+void SocketDeadline::cancel()
+{
+    if (timer) {
+        timers.cancel(timer);
+        timer = 0;
+    }
+}
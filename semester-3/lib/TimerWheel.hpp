@@ -0,0 +1,80 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Hashed timer wheel driven by its own thread. Scheduling and cancelling
+// are O(1), which matters when every connection re-arms a timer for each
+// request. Expiry is accurate to one tick.
+//
+// Callbacks run on the wheel thread with the wheel locked, so they must be
+// short and must not call back into the wheel; in exchange, once cancel()
+// returns the callback is guaranteed not to run.
+class TimerWheel
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+    using TimerId = uint64_t;
+
+  private:
+    struct Timer {
+        TimerId id;
+        size_t rounds;
+        Callback callback;
+    };
+    struct Position {
+        size_t slot;
+        std::list<Timer>::iterator timer;
+    };
+
+    const Clock::duration tick;
+    std::vector<std::list<Timer>> slots;
+    std::unordered_map<TimerId, Position> timers;
+    size_t cursor = 0;
+    TimerId nextId = 1;
+
+    std::mutex mutex;
+    std::condition_variable stopping;
+    bool stopped = false;
+    std::thread thread;
+
+    void run();
+
+  public:
+    TimerWheel(Clock::duration tick = std::chrono::milliseconds(100), size_t slotCount = 512);
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+    ~TimerWheel();
+
+    TimerId schedule(Clock::duration timeout, Callback callback);
+    // Returns false if the timer has already fired or didn't exist
+    bool cancel(TimerId id);
+};
+
+// Shuts a socket down unless cancelled in time. Shutting down rather than
+// closing wakes up whatever the connection is blocked on (a thread in
+// recv() or a coroutine waiting on the event loop) and leaves closing the
+// descriptor to its owner.
+class SocketDeadline
+{
+  private:
+    TimerWheel &timers;
+    int socketFd;
+    TimerWheel::TimerId timer = 0;
+
+  public:
+    SocketDeadline(TimerWheel &timers, int socketFd);
+    SocketDeadline(const SocketDeadline &) = delete;
+    SocketDeadline &operator=(const SocketDeadline &) = delete;
+    ~SocketDeadline();
+
+    void set(TimerWheel::Clock::duration timeout);
+    void cancel();
+};
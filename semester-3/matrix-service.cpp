@@ -0,0 +1,24 @@
+#include "lib/ComputePool.hpp"
+#include "lib/HttpServer.hpp"
+#include "lib/MatrixService.hpp"
+#include "lib/Router.hpp"
+#include <thread>
+
+// curl --data-binary @request.txt 'localhost:8082/multiply?a=dense&b=sparse'
+int main()
+{
+    // One multiplication per core; a few more may wait, the rest get 503
+    ComputePool pool(std::thread::hardware_concurrency(), 2 * std::thread::hardware_concurrency());
+
+    ServerMetrics metrics;
+    Router router;
+    router.post("/multiply", MatrixService(pool));
+    router.get("/metrics", [&metrics](const Request &request) {
+        return std::unique_ptr<Response>(new StringResponse(metrics.render(), ServerMetrics::CONTENT_TYPE));
+    });
+
+    HttpServerOptions options;
+    options.maxBodyBytes = 256 * 1024 * 1024;
+    options.metrics = &metrics;
+    HttpServer server("8082", router, options);
+}
@@ -1,3 +1,4 @@
+#include "../lib/krylov.hpp"
 #include "../lib/matrix.hpp"
 #include <cmath>
 #include <iomanip>
@@ -60,11 +61,13 @@ static math::matrix_value error(const math::vector &solution, const math::vector
 static math::vector
 simpleIteration(const math::Matrix &H, const math::Matrix &g, const math::vector &realSolution, int *steps = nullptr)
 {
-    math::Matrix result = g;
+    math::Matrix result = g, next = g;
 
     int k = -1;
     while (++k, error(result.m_values, realSolution) > EPSILON) {
-        result = H * result + g;
+        next = g;
+        next.addProduct(H, result);
+        std::swap(result, next);
     }
 
     if (steps) {
@@ -170,4 +173,10 @@ int main()
     std::cout << "Seidel solution:     " << seidelSolution << ", calculated in " << seidelSteps << " steps" << std::endl;
     auto relaxSolution = relaxation(H, g, realSolution, &relaxSteps);
     std::cout << "Relaxation solution: " << relaxSolution << ", calculated in " << relaxSteps << " steps" << std::endl;
+
+    math::SolverOptions options;
+    options.preconditioner = math::getILU0Preconditioner(math::SparseMatrix(A));
+    math::vector gmresSolution(b.size());
+    auto gmres = math::solveLinearSystemUsing::gmres(math::getOperator(A), b, gmresSolution, options);
+    std::cout << "GMRES solution:      " << gmresSolution << ", calculated in " << gmres.iterations << " steps" << std::endl;
 }
\ No newline at end of file
@@ -1,19 +1,23 @@
+#include "../lib/eigen.hpp"
+#include "../lib/lanczos.hpp"
 #include "../lib/matrix.hpp"
 #include <cmath>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <numbers>
 #include <utility>
 
 static constexpr long double EPSILON = 1e-6;
 
-math::matrix_value estimateError(math::Matrix A, math::vector Y, math::matrix_value l)
+math::matrix_value estimateError(const math::Matrix &A, const math::vector &Y, math::matrix_value l)
 {
-    return euclideanNorm(A * Y - l * Y) / euclideanNorm(Y);
+    return math::nrm2(A * Y - l * Y) / math::nrm2(Y);
 }
 
 std::tuple<math::matrix_value, math::vector, int> getPowerEigenvector(const math::Matrix &A, long double e)
 {
-    math::vector Y(A.m_height);
+    math::vector Y(A.m_height), AY(A.m_height);
     math::matrix_value l = 0;
 
     for (size_t i = 0; i < A.m_height; i++) {
@@ -24,7 +28,8 @@ std::tuple<math::matrix_value, math::vector, int> getPowerEigenvector(const math
     do {
         steps++;
         auto y0 = Y[0];
-        Y = A * Y;
+        math::gemv(1, A, Y, 0, AY);
+        std::swap(Y, AY);
         l = Y[0] / y0;
     } while (estimateError(A, Y, l) > e);
 
@@ -47,7 +52,7 @@ std::tuple<math::matrix_value, math::vector, int> getScalarEigenvector(const mat
     int steps = 0;
     do {
         steps++;
-        *Y2 = A * (*Y1);
+        math::gemv(1, A, *Y1, 0, *Y2);
         l = ((*Y2) * (*Y1)) / ((*Y1) * (*Y1));
         std::swap(Y1, Y2);
     } while (estimateError(A, *Y1, l) > e);
@@ -116,6 +121,13 @@ int main()
     }
     std::cout << std::endl;
 
+    auto householderResult = math::getSymmetricEigenvectors(m);
+    std::cout << "Result by Householder and QL:" << std::endl;
+    for (auto &&[value, vector] : householderResult) {
+        std::cout << "> Eigenvalue " << value << ", eigenvector " << vector << std::endl;
+    }
+    std::cout << std::endl;
+
     auto [powerValue, powerVector, powerSteps] = getPowerEigenvector(m, EPSILON);
     std::cout << "Result by powers:" << std::endl
               << "> Eigenvalue " << powerValue << ", eigenvector " << powerVector << " in " << powerSteps << " steps"
@@ -135,4 +147,34 @@ int main()
     std::cout << "Wielandt eigenvalue:" << std::endl
               << "> Eigenvalue " << wielandtValue << ", eigenvector " << wielandtVector << " in " << wielandtSteps << " steps"
               << std::endl;
-}
\ No newline at end of file
+    std::cout << std::endl;
+
+    // The smallest eigenvalues of the 1-D Laplacian, 4 sin^2(j pi / 2(n + 1)),
+    // are close together next to its largest ones, which makes them a hard case
+    // for Krylov methods
+    const size_t n = 400, k = 2;
+    math::linear_operator_t laplacian = [n](const math::vector &x, math::vector &y) {
+        for (size_t i = 0; i < n; i++) {
+            y[i] = 2 * x[i] - (i > 0 ? x[i - 1] : 0) - (i + 1 < n ? x[i + 1] : 0);
+        }
+    };
+    std::vector<long double> exact(k);
+    for (size_t j = 0; j < k; j++) {
+        exact[j] = 4 * std::pow(std::sin((j + 1) * std::numbers::pi_v<long double> / (2 * (n + 1))), 2);
+    }
+
+    // Rounding errors of about EPSILON ||A|| = 4 EPSILON limit how well so
+    // small an eigenvalue can be found, if math::value_t is a short type
+    math::KrylovEigenOptions options;
+    options.end = math::SpectrumEnd::Smallest;
+    options.tolerance = std::max<math::value_t>(
+        options.tolerance, 16 * std::numeric_limits<math::value_t>::epsilon() / math::value_t(exact[0])
+    );
+    auto lanczosResult = math::getLanczosEigenvectors(laplacian, n, k, options);
+    auto arnoldiResult = math::getArnoldiEigenvalues(laplacian, n, k, options);
+    std::cout << "Smallest eigenvalues of the " << n << "-point Laplacian:" << std::endl;
+    for (size_t j = 0; j < k; j++) {
+        std::cout << "> Exact " << exact[j] << ", by Lanczos " << lanczosResult[j].first << ", by Arnoldi "
+                  << arnoldiResult[j].real() << std::endl;
+    }
+}
@@ -0,0 +1,113 @@
+#include "../lib/functions.hpp"
+#include "../lib/lu.hpp"
+#include "../lib/matrix.hpp"
+#include "../lib/polynomials.hpp"
+#include "../lib/roots.hpp"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numbers>
+#include <random>
+#include <string>
+
+// Times the numerical core with whatever math::value_t it was built with,
+// along with the error of each result, so builds with different precisions
+// can be compared side by side:
+//
+//     make precision-benchmark
+//
+// builds and runs it for float, double and long double.
+//
+// Usage: precision-benchmark [matrix size]
+
+using math::value_t;
+
+static std::string getTypeName()
+{
+    if constexpr (std::is_same_v<value_t, float>) {
+        return "float";
+    } else if constexpr (std::is_same_v<value_t, double>) {
+        return "double";
+    } else {
+        return "long double";
+    }
+}
+
+template <typename F> static void measure(const std::string &name, F run)
+{
+    auto start = std::chrono::steady_clock::now();
+    value_t error = run();
+    std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+
+    std::cout << std::left << std::setw(24) << name << std::right << std::setw(12) << std::fixed
+              << std::setprecision(2) << time.count() << " ms" << std::setw(16) << std::scientific
+              << std::setprecision(3) << static_cast<double>(error) << std::endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 300;
+
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<double> distribution(-1, 1);
+    auto random = [&](size_t height, size_t width) {
+        math::Matrix m(height, width);
+        for (auto &&value : m.m_values) {
+            value = distribution(generator);
+        }
+        return m;
+    };
+
+    std::cout << "value_t: " << getTypeName() << " (" << std::numeric_limits<value_t>::digits10 << " digits)"
+              << std::endl
+              << std::left << std::setw(24) << "" << std::right << std::setw(15) << "time" << std::setw(16)
+              << "error" << std::endl;
+
+    math::Matrix A = random(n, n), B = random(n, n);
+    math::vector x(n, 1);
+    math::vector b = A * x;
+
+    // Checked against multiplying by the factors one at a time: Ce = A(Be)
+    measure("multiply", [&] {
+        math::Matrix C = A * B;
+        math::vector e(n, 1);
+        return euclideanNorm(C * e - A * (B * e)) / euclideanNorm(C * e);
+    });
+    measure("LU solve", [&] { return euclideanNorm(math::LU(A).solve(b) - x) / euclideanNorm(x); });
+    measure("Gauss solve", [&] { return euclideanNorm(math::solveLinearSystem(A, b) - x) / euclideanNorm(x); });
+    measure("invert", [&] { return (A.invert() * A - math::Matrix::id(n)).norm(); });
+
+    measure("Simpson, m = 100000", [] {
+        value_t integral = math::calculateIntegralUsing::compound::simpson(
+            [](value_t x) { return std::sin(x); }, 0, std::numbers::pi_v<value_t>, 100000
+        );
+        return std::abs(integral - 2);
+    });
+    measure("Gauss, n = 5, m = 1000", [] {
+        value_t integral = math::calculateIntegralUsing::compound::gauss(
+            [](value_t x) { return std::exp(x); }, 5, 0, 1, 1000, nullptr
+        );
+        return std::abs(integral - (std::exp(value_t(1)) - 1));
+    });
+
+    // (x - 1)^10, expanded, is as ill-conditioned as polynomials get near 1
+    measure("polynomial, 10^6 times", [] {
+        math::polynomials::Polynomial p({1, -10, 45, -120, 210, -252, 210, -120, 45, -10, 1});
+        value_t error = 0;
+        for (int i = 0; i < 1000000; i++) {
+            value_t x = 0.5 + i * 1e-6;
+            error = std::max(error, std::abs(p(x) - value_t(std::pow(x - 1, 10))));
+        }
+        return error;
+    });
+    // Down to a few units in the last place, whichever those are
+    measure("bisection", [] {
+        value_t epsilon = 8 * std::numeric_limits<value_t>::epsilon();
+        value_t root = math::findRootUsing::bisection([](value_t x) { return x * x - 2; }, 0, 2, epsilon);
+        return std::abs(root - std::numbers::sqrt2_v<value_t>);
+    });
+
+    return 0;
+}
@@ -1,3 +1,4 @@
+#include "../lib/eigen.hpp"
 #include "../lib/functions.hpp"
 #include "../lib/math.hpp"
 #include "../lib/matrix.hpp"
@@ -1,4 +1,6 @@
+#include "../lib/eigen.hpp"
 #include "../lib/io.hpp"
+#include "../lib/lu.hpp"
 #include "../lib/math.hpp"
 #include "../lib/matrix.hpp"
 #include <assert.h>
@@ -68,10 +70,10 @@ std::vector<math::vector> solveEulerImplicit(const math::Matrix &A, const math::
     size_t n = A.m_height;
     assert(n == A.m_width || "Only square matrices are supported");
 
-    auto W = (math::Matrix::id(n) - h * A).invert();
+    math::LU W(math::Matrix::id(n) - h * A);
     std::vector<math::vector> result = {Y0};
     for (size_t i = 0; i < iterations; i++) {
-        result.push_back(W * result[i]);
+        result.push_back(W.solve(result[i]));
     }
     return result;
 }
@@ -82,13 +84,16 @@ std::vector<math::vector> solveAdams(const math::Matrix &A, const math::vector &
     assert(n == A.m_width || "Only square matrices are supported");
 
     auto E = math::Matrix::id(n);
-    auto W = (E - (5.0 * h / 12.0) * A).invert();
-    auto W1 = W * (E + (2.0 * h / 3.0) * A);
-    auto W2 = W * ((-h / 12.0) * A);
+    math::LU W(E - (5.0 * h / 12.0) * A);
+    auto W1 = E + (2.0 * h / 3.0) * A;
+    auto W2 = (-h / 12.0) * A;
 
-    std::vector<math::vector> result = {Y0, (E - h * A).invert() * Y0};
+    std::vector<math::vector> result = {Y0, math::LU(E - h * A).solve(Y0)};
+    math::vector rhs(n);
     for (size_t i = 1; i < iterations; i++) {
-        result.push_back(W1 * result[i] + W2 * result[i - 1]);
+        math::gemv(1, W1, result[i], 0, rhs);
+        math::gemv(1, W2, result[i - 1], 1, rhs);
+        result.push_back(W.solve(rhs));
     }
     return result;
 }
@@ -0,0 +1,746 @@
+#include "pde.hpp"
+#include "../../lib/lu.hpp"
+#include <algorithm>
+#include <barrier>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <numbers>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace pde
+{
+    using math::Matrix;
+    using std::numbers::pi;
+
+    EllipticProblem::EllipticProblem(
+        value_t lx,
+        value_t ly,
+        size_t n,
+        size_t m,
+        two_arg_function_t p,
+        two_arg_function_t q,
+        two_arg_function_t f,
+        two_arg_function_t mu,
+        std::pair<value_t, value_t> pBounds,
+        std::pair<value_t, value_t> qBounds
+    )
+        : m_lx(lx), m_ly(ly), m_n(n), m_m(m), m_hx(lx / value_t(n)), m_hy(ly / value_t(m)), m_f(n + 1, m + 1),
+          m_boundary(n + 1, m + 1)
+    {
+        if (n < 2 || m < 2) {
+            throw std::runtime_error("Grid is too small");
+        }
+
+        auto [c1, c2] = pBounds;
+        auto [d1, d2] = qBounds;
+        value_t sx = std::sin(pi * m_hx / (2 * lx)), sy = std::sin(pi * m_hy / (2 * ly));
+        value_t cx = std::cos(pi * m_hx / (2 * lx)), cy = std::cos(pi * m_hy / (2 * ly));
+        m_delta = c1 * 4 * sx * sx / (m_hx * m_hx) + d1 * 4 * sy * sy / (m_hy * m_hy);
+        m_Delta = c2 * 4 * cx * cx / (m_hx * m_hx) + d2 * 4 * cy * cy / (m_hy * m_hy);
+
+        for (size_t j = 0; j <= m; j++) {
+            for (size_t i = 0; i <= n; i++) {
+                value_t x = m_hx * i, y = m_hy * j;
+                m_f(i, j) = f(x, y);
+                if (i == 0 || i == n || j == 0 || j == m) {
+                    m_boundary(i, j) = mu(x, y);
+                }
+            }
+        }
+
+        // How node (i, j) is coupled to (i - 1, j) and to (i, j - 1)
+        auto px = [&](size_t i, size_t j) { return p(m_hx * (i - value_t(0.5)), m_hy * j) / (m_hx * m_hx); };
+        auto qy = [&](size_t i, size_t j) { return q(m_hx * i, m_hy * (j - value_t(0.5))) / (m_hy * m_hy); };
+
+        size_t size = (n + 1) * (m + 1);
+        Stencil &s = m_stencil;
+        for (auto *coefficients : {&s.m_west, &s.m_east, &s.m_south, &s.m_north, &s.m_center}) {
+            coefficients->assign(size, 0);
+        }
+        for (size_t j = 1; j < m; j++) {
+            for (size_t i = 1; i < n; i++) {
+                size_t c = j * (n + 1) + i;
+                s.m_west[c] = px(i, j);
+                s.m_east[c] = px(i + 1, j);
+                s.m_south[c] = qy(i, j);
+                s.m_north[c] = qy(i, j + 1);
+                s.m_center[c] = s.m_west[c] + s.m_east[c] + s.m_south[c] + s.m_north[c];
+            }
+        }
+    }
+
+    Matrix EllipticProblem::discretize(two_arg_function_t u) const
+    {
+        Matrix U(m_n + 1, m_m + 1);
+        for (size_t j = 0; j <= m_m; j++) {
+            for (size_t i = 0; i <= m_n; i++) {
+                U(i, j) = u(m_hx * i, m_hy * j);
+            }
+        }
+        return U;
+    }
+
+    Matrix EllipticProblem::initialGuess() const
+    {
+        return m_boundary;
+    }
+
+    // (LU)(c) for the flat index c of an inner node, h being the height of
+    // the grid matrices. In differences, so it is exactly 0 on constants
+    static inline value_t applyAt(const Stencil &s, const value_t *u, size_t c, size_t h)
+    {
+        return s.m_east[c] * (u[c + 1] - u[c]) - s.m_west[c] * (u[c] - u[c - 1]) + s.m_north[c] * (u[c + h] - u[c]) -
+               s.m_south[c] * (u[c] - u[c - h]);
+    }
+
+    value_t EllipticProblem::apply(const Matrix &U, size_t i, size_t j) const
+    {
+        return applyAt(m_stencil, U.m_values.data(), j * U.m_height + i, U.m_height);
+    }
+
+    void EllipticProblem::residual(const Matrix &U, Matrix &R) const
+    {
+        const value_t *u = U.m_values.data(), *f = m_f.m_values.data();
+        value_t *r = R.m_values.data();
+        size_t h = m_n + 1;
+        for (size_t j = 1; j < m_m; j++) {
+            for (size_t c = j * h + 1; c < j * h + m_n; c++) {
+                r[c] = applyAt(m_stencil, u, c, h) + f[c];
+            }
+        }
+    }
+
+    value_t EllipticProblem::residualNorm(const Matrix &U) const
+    {
+        const value_t *u = U.m_values.data(), *f = m_f.m_values.data();
+        size_t h = m_n + 1;
+        value_t result = 0;
+        for (size_t j = 1; j < m_m; j++) {
+            for (size_t c = j * h + 1; c < j * h + m_n; c++) {
+                result = std::max(result, std::abs(f[c] + applyAt(m_stencil, u, c, h)));
+            }
+        }
+        return result;
+    }
+
+    value_t EllipticProblem::xi() const
+    {
+        return m_delta / m_Delta;
+    }
+
+    value_t EllipticProblem::rho() const
+    {
+        return (m_Delta - m_delta) / (m_Delta + m_delta);
+    }
+
+    value_t distance(const Matrix &U, const Matrix &V)
+    {
+        value_t result = 0;
+        for (size_t j = 1; j + 1 < U.m_width; j++) {
+            for (size_t i = 1; i + 1 < U.m_height; i++) {
+                result = std::max(result, std::abs(U(i, j) - V(i, j)));
+            }
+        }
+        return result;
+    }
+
+    Matrix iterate(const step_t &step, Matrix U0, size_t iterations, const iteration_callback_t &callback)
+    {
+        Matrix U1 = U0;
+        Matrix *Uk = &U0, *Uk1 = &U1;
+
+        for (size_t k = 1; k <= iterations; k++) {
+            step(k, *Uk, *Uk1);
+            std::swap(Uk, Uk1);
+            if (callback && !callback(k, *Uk, *Uk1)) {
+                break;
+            }
+        }
+        return std::move(*Uk);
+    }
+
+    // The stable order of the Chebyshev parameters: theta[k] is the odd
+    // multiple of pi / (2 * cycle) for the k-th iteration of a cycle
+    static std::vector<size_t> getChebyshevOrder(size_t cycle)
+    {
+        if (cycle == 0 || (cycle & (cycle - 1))) {
+            throw std::runtime_error("Chebyshev cycle has to be a power of two");
+        }
+
+        std::vector<size_t> theta(cycle, 1);
+        for (size_t m = 1; m < cycle; m *= 2) {
+            for (size_t i = m; i > 0; i--) {
+                theta[2 * i - 2] = theta[i - 1];
+            }
+            for (size_t i = 1; i <= m; i++) {
+                theta[2 * i - 1] = 4 * m - theta[2 * i - 2];
+            }
+        }
+        return theta;
+    }
+
+    // Solves (E + omega R1)(E + omega R2) w = Phi, where R1 and R2 are the
+    // lower and upper triangular halves of -L, for w that is 0 on the boundary
+    static void solveTriangles(const EllipticProblem &problem, value_t omega, const Matrix &Phi, Matrix &w)
+    {
+        const Stencil &s = problem.m_stencil;
+        const value_t *phi = Phi.m_values.data();
+        value_t *v = w.m_values.data();
+        size_t n = problem.m_n, m = problem.m_m, h = n + 1;
+        std::fill(w.m_values.begin(), w.m_values.end(), 0);
+
+        for (size_t j = 1; j < m; j++) {
+            for (size_t c = j * h + 1; c < j * h + n; c++) {
+                value_t c1 = omega * s.m_west[c], c2 = omega * s.m_south[c];
+                v[c] = (c1 * v[c - 1] + c2 * v[c - h] + phi[c]) / (1 + c1 + c2);
+            }
+        }
+        for (size_t j = m - 1; j > 0; j--) {
+            for (size_t c = j * h + n - 1; c > j * h; c--) {
+                value_t c1 = omega * s.m_east[c], c2 = omega * s.m_north[c];
+                v[c] = (c1 * v[c + 1] + c2 * v[c + h] + v[c]) / (1 + c1 + c2);
+            }
+        }
+    }
+
+    // Fewer columns per thread are not worth waking it
+    static constexpr size_t MIN_COLUMNS_PER_THREAD = 16;
+
+    // Threads kept between sweeps: starting them for every colour of every
+    // sweep cost more than the sweep itself on the coarser multigrid grids.
+    // run() calls work(id) on each of them, the caller being thread 0, and
+    // returns once all are done; sync() inside it waits for all of them.
+    class Team
+    {
+        size_t m_size;
+        const std::function<void(size_t id)> *m_work = nullptr;
+        bool m_stopping = false;
+        std::barrier<> m_start, m_sync, m_done;
+        std::vector<std::thread> m_workers;
+
+        void stop()
+        {
+            m_stopping = true;
+            // Arrives for the caller and for the threads that never started
+            (void)m_start.arrive(m_size - m_workers.size());
+            for (auto &&worker : m_workers) {
+                worker.join();
+            }
+        }
+
+      public:
+        explicit Team(size_t size) : m_size(size), m_start(size), m_sync(size), m_done(size)
+        {
+            try {
+                for (size_t id = 1; id < size; id++) {
+                    m_workers.emplace_back([this, id] {
+                        while (m_start.arrive_and_wait(), !m_stopping) {
+                            (*m_work)(id);
+                            m_done.arrive_and_wait();
+                        }
+                    });
+                }
+            } catch (...) {
+                stop();
+                throw;
+            }
+        }
+        Team(const Team &) = delete;
+        Team &operator=(const Team &) = delete;
+        ~Team()
+        {
+            stop();
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        void run(const std::function<void(size_t id)> &work)
+        {
+            m_work = &work;
+            m_start.arrive_and_wait();
+            work(0);
+            m_done.arrive_and_wait();
+        }
+
+        void sync()
+        {
+            m_sync.arrive_and_wait();
+        }
+    };
+
+    static size_t getThreadCount(size_t threads)
+    {
+        return threads ? threads : std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    // One in-place sweep of relaxation for -LU = F on an n x m grid, in
+    // red-black order. A node only depends on nodes of the other colour, so
+    // the nodes of one colour can be updated in any order, in parallel, and
+    // every other node of a column at a time. The columns are split between
+    // the team, which meets once between the colours.
+    //
+    // The colours stay interleaved in the grid, so the inner loop has stride
+    // 2 and doesn't vectorize. Storing them apart would mean reordering U and
+    // F in and out on every step, a pass over the grid as costly as the sweep,
+    // since the callers, the residual and the grid transfers all index them
+    // in natural order.
+    static void
+    relaxRedBlack(const Stencil &s, size_t n, size_t m, const value_t *f, value_t *u, value_t omega, Team &team)
+    {
+        size_t h = n + 1, columns = m - 1;
+        auto relax = [&](size_t colour, size_t from, size_t to) {
+            for (size_t j = from; j < to; j++) {
+                // The first inner node with (i + j) % 2 == colour
+                for (size_t c = j * h + 1 + (1 + j + colour) % 2; c < j * h + n; c += 2) {
+                    value_t seidel =
+                        (s.m_west[c] * u[c - 1] + s.m_east[c] * u[c + 1] + s.m_south[c] * u[c - h] + s.m_north[c] * u[c + h] +
+                         f[c]) /
+                        s.m_center[c];
+                    u[c] += omega * (seidel - u[c]);
+                }
+            }
+        };
+
+        size_t threads = std::min(team.size(), std::max<size_t>(columns / MIN_COLUMNS_PER_THREAD, 1));
+        if (threads <= 1) {
+            relax(0, 1, m);
+            relax(1, 1, m);
+            return;
+        }
+        team.run([&](size_t id) {
+            // Threads past `threads` get no columns, but still meet the rest
+            size_t from = 1 + columns * std::min(id, threads) / threads;
+            size_t to = 1 + columns * std::min(id + 1, threads) / threads;
+            relax(0, from, to);
+            team.sync();
+            relax(1, from, to);
+        });
+    }
+
+    // One grid of the multigrid hierarchy, the finest being the problem's.
+    // On the coarser ones U is the correction, which is 0 on the boundary.
+    struct Level {
+        size_t m_n, m_m;
+        Stencil m_stencil;
+        Matrix m_U, m_F, m_R;
+    };
+
+    // Above this many inner nodes the coarsest grid is too big to solve
+    // directly
+    static constexpr size_t MAX_DIRECT_NODES = 1024;
+
+    // The operator on the grid twice as coarse: a coarse coupling spans two
+    // fine ones, and gets their mean, rescaled from h^2 to (2h)^2
+    static Stencil coarsen(const Stencil &fine, size_t n, size_t m)
+    {
+        size_t h = n + 1, N = n / 2, M = m / 2, H = N + 1;
+        Stencil s;
+        for (auto *coefficients : {&s.m_west, &s.m_east, &s.m_south, &s.m_north, &s.m_center}) {
+            coefficients->assign(H * (M + 1), 0);
+        }
+        for (size_t J = 1; J < M; J++) {
+            for (size_t I = 1; I < N; I++) {
+                size_t C = J * H + I, c = 2 * J * h + 2 * I;
+                s.m_west[C] = (fine.m_west[c - 1] + fine.m_west[c]) / 8;
+                s.m_east[C] = (fine.m_east[c] + fine.m_east[c + 1]) / 8;
+                s.m_south[C] = (fine.m_south[c - h] + fine.m_south[c]) / 8;
+                s.m_north[C] = (fine.m_north[c] + fine.m_north[c + h]) / 8;
+                s.m_center[C] = s.m_west[C] + s.m_east[C] + s.m_south[C] + s.m_north[C];
+            }
+        }
+        return s;
+    }
+
+    // Halves the grid while both sides stay even, down to a single inner
+    // node at most
+    static std::vector<Level> getLevels(const EllipticProblem &problem)
+    {
+        std::vector<Level> levels;
+        size_t n = problem.m_n, m = problem.m_m;
+        levels.push_back({n, m, problem.m_stencil, problem.m_boundary, problem.m_f, Matrix(n + 1, m + 1)});
+        while (n % 2 == 0 && m % 2 == 0 && n > 2 && m > 2) {
+            Stencil stencil = coarsen(levels.back().m_stencil, n, m);
+            n /= 2;
+            m /= 2;
+            levels.push_back({n, m, std::move(stencil), Matrix(n + 1, m + 1), Matrix(n + 1, m + 1), Matrix(n + 1, m + 1)});
+        }
+
+        if ((n - 1) * (m - 1) > MAX_DIRECT_NODES) {
+            throw std::runtime_error("Grid doesn't coarsen enough for multigrid");
+        }
+        return levels;
+    }
+
+    // -LU = F on the inner nodes of the coarsest grid, as a dense system
+    // with the boundary values moved to the right-hand side
+    static void solveDirectly(const Level &level, const math::LU &lu, Matrix &U, const Matrix &F)
+    {
+        size_t n = level.m_n, m = level.m_m, h = n + 1;
+        const Stencil &s = level.m_stencil;
+        math::vector b((n - 1) * (m - 1));
+        for (size_t j = 1; j < m; j++) {
+            for (size_t i = 1; i < n; i++) {
+                size_t c = j * h + i;
+                b[(j - 1) * (n - 1) + i - 1] = F(i, j) + (i == 1 ? s.m_west[c] * U(0, j) : 0) +
+                                               (i == n - 1 ? s.m_east[c] * U(n, j) : 0) + (j == 1 ? s.m_south[c] * U(i, 0) : 0) +
+                                               (j == m - 1 ? s.m_north[c] * U(i, m) : 0);
+            }
+        }
+
+        math::vector x = lu.solve(b);
+        for (size_t j = 1; j < m; j++) {
+            for (size_t i = 1; i < n; i++) {
+                U(i, j) = x[(j - 1) * (n - 1) + i - 1];
+            }
+        }
+    }
+
+    static math::LU getDirectSolver(const Level &level)
+    {
+        size_t n = level.m_n, m = level.m_m, h = n + 1, size = (n - 1) * (m - 1);
+        const Stencil &s = level.m_stencil;
+        Matrix A(size, size);
+        for (size_t j = 1; j < m; j++) {
+            for (size_t i = 1; i < n; i++) {
+                size_t c = j * h + i, row = (j - 1) * (n - 1) + i - 1;
+                A(row, row) = s.m_center[c];
+                if (i > 1) {
+                    A(row, row - 1) = -s.m_west[c];
+                }
+                if (i < n - 1) {
+                    A(row, row + 1) = -s.m_east[c];
+                }
+                if (j > 1) {
+                    A(row, row - (n - 1)) = -s.m_south[c];
+                }
+                if (j < m - 1) {
+                    A(row, row + (n - 1)) = -s.m_north[c];
+                }
+            }
+        }
+        return math::LU(std::move(A));
+    }
+
+    // Full weighting of the fine residual into the coarse right-hand side
+    static void restrictResidual(const Level &fine, Level &coarse)
+    {
+        const Matrix &R = fine.m_R;
+        for (size_t J = 1; J < coarse.m_m; J++) {
+            for (size_t I = 1; I < coarse.m_n; I++) {
+                size_t i = 2 * I, j = 2 * J;
+                coarse.m_F(I, J) = (4 * R(i, j) + 2 * (R(i - 1, j) + R(i + 1, j) + R(i, j - 1) + R(i, j + 1)) +
+                                    R(i - 1, j - 1) + R(i + 1, j - 1) + R(i - 1, j + 1) + R(i + 1, j + 1)) /
+                                   16;
+            }
+        }
+    }
+
+    // Bilinear interpolation of the coarse U to the inner fine nodes: the
+    // mean of the (up to four distinct) coarse nodes around each one
+    static void prolong(const Level &coarse, Level &fine, bool add)
+    {
+        const Matrix &V = coarse.m_U;
+        for (size_t j = 1; j < fine.m_m; j++) {
+            for (size_t i = 1; i < fine.m_n; i++) {
+                value_t v = (V(i / 2, j / 2) + V((i + 1) / 2, j / 2) + V(i / 2, (j + 1) / 2) + V((i + 1) / 2, (j + 1) / 2)) / 4;
+                fine.m_U(i, j) = add ? fine.m_U(i, j) + v : v;
+            }
+        }
+    }
+
+    static void vCycle(std::vector<Level> &levels, size_t l, const math::LU &lu, size_t smoothing, Team &team)
+    {
+        Level &level = levels[l];
+        if (l + 1 == levels.size()) {
+            solveDirectly(level, lu, level.m_U, level.m_F);
+            return;
+        }
+
+        value_t *u = level.m_U.m_values.data();
+        const value_t *f = level.m_F.m_values.data();
+        value_t *r = level.m_R.m_values.data();
+        for (size_t sweep = 0; sweep < smoothing; sweep++) {
+            relaxRedBlack(level.m_stencil, level.m_n, level.m_m, f, u, 1, team);
+        }
+
+        size_t h = level.m_n + 1;
+        for (size_t j = 1; j < level.m_m; j++) {
+            for (size_t c = j * h + 1; c < j * h + level.m_n; c++) {
+                r[c] = applyAt(level.m_stencil, u, c, h) + f[c];
+            }
+        }
+        Level &coarse = levels[l + 1];
+        restrictResidual(level, coarse);
+        std::fill(coarse.m_U.m_values.begin(), coarse.m_U.m_values.end(), 0);
+        vCycle(levels, l + 1, lu, smoothing, team);
+        prolong(coarse, level, true);
+
+        for (size_t sweep = 0; sweep < smoothing; sweep++) {
+            relaxRedBlack(level.m_stencil, level.m_n, level.m_m, f, u, 1, team);
+        }
+    }
+
+    Matrix fullMultigrid(const EllipticProblem &problem, size_t smoothing, size_t threads)
+    {
+        Team team(getThreadCount(threads));
+        std::vector<Level> levels = getLevels(problem);
+        math::LU lu = getDirectSolver(levels.back());
+
+        // The coarser problems are the same one on the coarser grids, so F
+        // and the boundary values are those of the fine nodes there
+        for (size_t l = 1; l < levels.size(); l++) {
+            const Level &fine = levels[l - 1];
+            Level &coarse = levels[l];
+            for (size_t J = 0; J <= coarse.m_m; J++) {
+                for (size_t I = 0; I <= coarse.m_n; I++) {
+                    coarse.m_F(I, J) = fine.m_F(2 * I, 2 * J);
+                    coarse.m_U(I, J) = fine.m_U(2 * I, 2 * J);
+                }
+            }
+        }
+
+        // Each solution is the initial guess one level up. A V-cycle there
+        // overwrites only the problems below it, which are solved by then.
+        solveDirectly(levels.back(), lu, levels.back().m_U, levels.back().m_F);
+        for (size_t l = levels.size() - 1; l > 0; l--) {
+            prolong(levels[l], levels[l - 1], false);
+            vCycle(levels, l - 1, lu, smoothing, team);
+        }
+        return std::move(levels[0].m_U);
+    }
+
+    namespace solveUsing
+    {
+        // The inner loops below run over flat indices c = j * h + i of the
+        // column-major grid matrices and read the stencil arrays directly,
+        // so that a sweep is plain arithmetic on contiguous memory
+
+        step_t simpleIteration(const EllipticProblem &problem)
+        {
+            return [&problem](size_t k, const Matrix &U, Matrix &Unext) {
+                const Stencil &s = problem.m_stencil;
+                const value_t *u = U.m_values.data(), *f = problem.m_f.m_values.data();
+                value_t *next = Unext.m_values.data();
+                size_t h = problem.m_n + 1;
+                for (size_t j = 1; j < problem.m_m; j++) {
+                    for (size_t c = j * h + 1; c < j * h + problem.m_n; c++) {
+                        next[c] = (s.m_west[c] * u[c - 1] + s.m_east[c] * u[c + 1] + s.m_south[c] * u[c - h] +
+                                   s.m_north[c] * u[c + h] + f[c]) /
+                                  s.m_center[c];
+                    }
+                }
+            };
+        }
+
+        // U + tau (LU + F)
+        static void stepWithResidual(const EllipticProblem &problem, value_t tau, const Matrix &U, Matrix &Unext)
+        {
+            const value_t *u = U.m_values.data(), *f = problem.m_f.m_values.data();
+            value_t *next = Unext.m_values.data();
+            size_t h = problem.m_n + 1;
+            for (size_t j = 1; j < problem.m_m; j++) {
+                for (size_t c = j * h + 1; c < j * h + problem.m_n; c++) {
+                    next[c] = u[c] + tau * (applyAt(problem.m_stencil, u, c, h) + f[c]);
+                }
+            }
+        }
+
+        step_t simpleIterationOptimal(const EllipticProblem &problem)
+        {
+            value_t tau = 2 / (problem.m_delta + problem.m_Delta);
+            return [&problem, tau](size_t k, const Matrix &U, Matrix &Unext) {
+                stepWithResidual(problem, tau, U, Unext);
+            };
+        }
+
+        // In place, so the neighbours before (i, j) are already new
+        static step_t relaxation(const EllipticProblem &problem, value_t omega)
+        {
+            return [&problem, omega](size_t k, const Matrix &U, Matrix &Unext) {
+                const Stencil &s = problem.m_stencil;
+                const value_t *f = problem.m_f.m_values.data();
+                size_t h = problem.m_n + 1;
+                Unext = U;
+                value_t *u = Unext.m_values.data();
+                for (size_t j = 1; j < problem.m_m; j++) {
+                    for (size_t c = j * h + 1; c < j * h + problem.m_n; c++) {
+                        value_t seidel = (s.m_west[c] * u[c - 1] + s.m_east[c] * u[c + 1] + s.m_south[c] * u[c - h] +
+                                          s.m_north[c] * u[c + h] + f[c]) /
+                                         s.m_center[c];
+                        u[c] += omega * (seidel - u[c]);
+                    }
+                }
+            };
+        }
+
+        step_t seidel(const EllipticProblem &problem)
+        {
+            return relaxation(problem, 1);
+        }
+
+        static value_t getOptimalOmega(const EllipticProblem &problem)
+        {
+            value_t rho = problem.rho();
+            return 2 / (1 + std::sqrt(1 - rho * rho));
+        }
+
+        step_t upperRelaxation(const EllipticProblem &problem, value_t omega)
+        {
+            return relaxation(problem, omega == 0 ? getOptimalOmega(problem) : omega);
+        }
+
+        static step_t redBlackRelaxation(const EllipticProblem &problem, value_t omega, size_t threads)
+        {
+            // Shared, as step_t has to be copyable
+            auto team = std::make_shared<Team>(getThreadCount(threads));
+            return [&problem, omega, team](size_t k, const Matrix &U, Matrix &Unext) {
+                Unext = U;
+                relaxRedBlack(
+                    problem.m_stencil, problem.m_n, problem.m_m, problem.m_f.m_values.data(), Unext.m_values.data(), omega, *team
+                );
+            };
+        }
+
+        step_t redBlackSeidel(const EllipticProblem &problem, size_t threads)
+        {
+            return redBlackRelaxation(problem, 1, threads);
+        }
+
+        step_t redBlackUpperRelaxation(const EllipticProblem &problem, value_t omega, size_t threads)
+        {
+            return redBlackRelaxation(problem, omega == 0 ? getOptimalOmega(problem) : omega, threads);
+        }
+
+        step_t chebyshevParams(const EllipticProblem &problem, size_t cycle)
+        {
+            std::vector<value_t> taus;
+            for (size_t theta : getChebyshevOrder(cycle)) {
+                value_t delta = problem.m_delta, Delta = problem.m_Delta;
+                taus.push_back(2 / (Delta + delta + (Delta - delta) * std::cos(pi * theta / (2 * value_t(cycle)))));
+            }
+
+            return [&problem, taus](size_t k, const Matrix &U, Matrix &Unext) {
+                stepWithResidual(problem, taus[(k - 1) % taus.size()], U, Unext);
+            };
+        }
+
+        // U + tau_k w, where w solves the triangles for the residual
+        static step_t triangles(const EllipticProblem &problem, std::vector<value_t> taus)
+        {
+            value_t omega = 2 / std::sqrt(problem.m_delta * problem.m_Delta);
+            Matrix Phi(problem.m_n + 1, problem.m_m + 1), w = Phi;
+
+            return [&problem, taus, omega, Phi, w](size_t k, const Matrix &U, Matrix &Unext) mutable {
+                problem.residual(U, Phi);
+                solveTriangles(problem, omega, Phi, w);
+
+                value_t tau = taus[(k - 1) % taus.size()];
+                const value_t *u = U.m_values.data(), *v = w.m_values.data();
+                value_t *next = Unext.m_values.data();
+                size_t h = problem.m_n + 1;
+                for (size_t j = 1; j < problem.m_m; j++) {
+                    for (size_t c = j * h + 1; c < j * h + problem.m_n; c++) {
+                        next[c] = u[c] + tau * v[c];
+                    }
+                }
+            };
+        }
+
+        static std::pair<value_t, value_t> getTriangleBounds(const EllipticProblem &problem)
+        {
+            value_t sqrtXi = std::sqrt(problem.xi());
+            return {problem.m_delta / (2 + 2 * sqrtXi), problem.m_delta / (4 * sqrtXi)};
+        }
+
+        step_t alternatingTriangles(const EllipticProblem &problem)
+        {
+            auto [gamma1, gamma2] = getTriangleBounds(problem);
+            return triangles(problem, {2 / (gamma1 + gamma2)});
+        }
+
+        step_t alternatingTrianglesChebyshev(const EllipticProblem &problem, size_t cycle)
+        {
+            auto [gamma1, gamma2] = getTriangleBounds(problem);
+            std::vector<value_t> taus;
+            for (size_t k = 1; k <= cycle; k++) {
+                value_t angle = pi * (2 * value_t(k) - 1) / (2 * value_t(cycle));
+                taus.push_back(2 / (gamma1 + gamma2 + (gamma2 - gamma1) * std::cos(angle)));
+            }
+            return triangles(problem, taus);
+        }
+
+        step_t alternatingDirections(const EllipticProblem &problem)
+        {
+            value_t tau = 2 / std::sqrt(problem.m_delta * problem.m_Delta);
+            Matrix half(problem.m_n + 1, problem.m_m + 1), S = half, T = half;
+
+            // Each half step is a set of tridiagonal systems along one
+            // direction, solved by the sweep method; in both halves the
+            // innermost loop runs along the columns of the grid, the
+            // second half solving all its systems side by side
+            return [&problem, tau, half, S, T](size_t k, const Matrix &U, Matrix &Unext) mutable {
+                half = U;
+                const Stencil &st = problem.m_stencil;
+                const value_t *u = U.m_values.data(), *f = problem.m_f.m_values.data();
+                value_t *next = Unext.m_values.data(), *v = half.m_values.data(), *s = S.m_values.data(),
+                        *t = T.m_values.data();
+                size_t n = problem.m_n, m = problem.m_m, h = n + 1;
+
+                for (size_t j = 1; j < m; j++) {
+                    s[j * h] = 0;
+                    t[j * h] = u[j * h];
+                    for (size_t c = j * h + 1; c < j * h + n; c++) {
+                        value_t A = st.m_west[c] * tau / 2, C = st.m_east[c] * tau / 2, B = A + C + 1;
+                        value_t G = -u[c] - tau / 2 *
+                                                (st.m_north[c] * (u[c + h] - u[c]) - st.m_south[c] * (u[c] - u[c - h]) + f[c]);
+                        value_t denominator = B - A * s[c - 1];
+                        s[c] = C / denominator;
+                        t[c] = (A * t[c - 1] - G) / denominator;
+                    }
+                    for (size_t c = j * h + n - 1; c > j * h; c--) {
+                        v[c] = s[c] * v[c + 1] + t[c];
+                    }
+                }
+
+                for (size_t c = 1; c < n; c++) {
+                    s[c] = 0;
+                    t[c] = v[c];
+                }
+                for (size_t j = 1; j < m; j++) {
+                    for (size_t c = j * h + 1; c < j * h + n; c++) {
+                        value_t A = st.m_south[c] * tau / 2, C = st.m_north[c] * tau / 2, B = A + C + 1;
+                        value_t G = -v[c] - tau / 2 *
+                                                (st.m_east[c] * (v[c + 1] - v[c]) - st.m_west[c] * (v[c] - v[c - 1]) + f[c]);
+                        value_t denominator = B - A * s[c - h];
+                        s[c] = C / denominator;
+                        t[c] = (A * t[c - h] - G) / denominator;
+                    }
+                }
+                for (size_t j = m - 1; j > 0; j--) {
+                    for (size_t c = j * h + 1; c < j * h + n; c++) {
+                        next[c] = s[c] * next[c + h] + t[c];
+                    }
+                }
+            };
+        }
+
+        step_t multigrid(const EllipticProblem &problem, size_t smoothing, size_t threads)
+        {
+            auto team = std::make_shared<Team>(getThreadCount(threads));
+            std::vector<Level> levels = getLevels(problem);
+            math::LU lu = getDirectSolver(levels.back());
+
+            return [levels, lu, smoothing, team](size_t k, const Matrix &U, Matrix &Unext) mutable {
+                levels[0].m_U = U;
+                vCycle(levels, 0, lu, smoothing, *team);
+                Unext = levels[0].m_U;
+            };
+        }
+    } // namespace solveUsing
+} // namespace pde
@@ -1,12 +1,122 @@
+#pragma once
 #include "../../lib/math.hpp"
+#include "../../lib/matrix.hpp"
+#include <functional>
+#include <utility>
+#include <vector>
 
 namespace pde
 {
     using math::two_arg_function_t;
     using math::value_t;
 
-    namespace solveUsing
+    // The five-point stencil of -L as flat arrays, one per coefficient, laid
+    // out like the grid matrices (node (i, j) at j * (n + 1) + i):
+    // -(LU)(i, j) = center U(i, j) - west U(i - 1, j) - east U(i + 1, j)
+    //             - south U(i, j - 1) - north U(i, j + 1),
+    // where center is the sum of the other four. Only inner nodes are set.
+    struct Stencil {
+        std::vector<value_t> m_west, m_east, m_south, m_north, m_center;
+    };
+
+    // -(p u_x)_x - (q u_y)_y = f in [0, lx] x [0, ly], u = mu on the boundary,
+    // with c1 <= p <= c2 and d1 <= q <= d2, on a grid of n x m steps. Grid
+    // functions are (n + 1) x (m + 1) matrices, U(i, j) being the value at
+    // (i hx, j hy); the scheme is -LU = F, with the usual five-point L.
+    class EllipticProblem
     {
+      public:
+        value_t m_lx, m_ly;
+        size_t m_n, m_m;
+        value_t m_hx, m_hy;
+        // Bounds of the spectrum of -L, from the bounds of p and q
+        value_t m_delta, m_Delta;
+        math::Matrix m_f, m_boundary;
+        // p and q at the half-nodes, sampled once, so that iterations call
+        // neither them nor Matrix::operator() in their inner loops
+        Stencil m_stencil;
+
+      public:
+        EllipticProblem(
+            value_t lx,
+            value_t ly,
+            size_t n,
+            size_t m,
+            two_arg_function_t p,
+            two_arg_function_t q,
+            two_arg_function_t f,
+            two_arg_function_t mu,
+            std::pair<value_t, value_t> pBounds,
+            std::pair<value_t, value_t> qBounds
+        );
+
+        math::Matrix discretize(two_arg_function_t u) const;
+        // mu on the boundary, 0 inside
+        math::Matrix initialGuess() const;
+
+        // (LU)(i, j) at an inner node
+        value_t apply(const math::Matrix &U, size_t i, size_t j) const;
+        // R = F + LU at the inner nodes, in a single sweep
+        void residual(const math::Matrix &U, math::Matrix &R) const;
+        // max |F + LU| over the inner nodes
+        value_t residualNorm(const math::Matrix &U) const;
+
+        // delta / Delta, and the spectral radius of simple iteration with the
+        // optimal parameter
+        value_t xi() const;
+        value_t rho() const;
+    };
 
-    }
+    // max |U - V| over the inner nodes
+    value_t distance(const math::Matrix &U, const math::Matrix &V);
+
+    // Makes Unext out of U on the k-th iteration (counting from 1). Both come
+    // with the boundary values, which a step keeps. The steps made by
+    // solveUsing refer to the problem, which has to outlive them.
+    using step_t = std::function<void(size_t k, const math::Matrix &U, math::Matrix &Unext)>;
+    // Called after every iteration; returning false stops
+    using iteration_callback_t = std::function<bool(size_t k, const math::Matrix &U, const math::Matrix &Uprev)>;
+
+    // `iterations` steps from U0 (fewer if the callback says so)
+    math::Matrix iterate(const step_t &step, math::Matrix U0, size_t iterations, const iteration_callback_t &callback = {});
+
+    // Full multigrid: solves the problem directly on the coarsest grid, then
+    // on every finer one starts from the bilinear interpolation of the last
+    // solution and makes a V-cycle (see solveUsing::multigrid). Gets within
+    // the discretization error in O(nm) operations.
+    math::Matrix fullMultigrid(const EllipticProblem &problem, size_t smoothing = 2, size_t threads = 0);
+
+    namespace solveUsing
+    {
+        // Jacobi
+        step_t simpleIteration(const EllipticProblem &problem);
+        // U + tau (LU + F) with tau = 2 / (delta + Delta)
+        step_t simpleIterationOptimal(const EllipticProblem &problem);
+        step_t seidel(const EllipticProblem &problem);
+        // Successive over-relaxation, by default with the optimal omega
+        step_t upperRelaxation(const EllipticProblem &problem, value_t omega = 0);
+        // The same two in red-black order: all nodes with even i + j, then all
+        // with odd, each colour updated at once over up to `threads` threads
+        // (all cores by default), which the step keeps for as long as it
+        // lives. The optimal omega is the same as above.
+        step_t redBlackSeidel(const EllipticProblem &problem, size_t threads = 0);
+        step_t redBlackUpperRelaxation(const EllipticProblem &problem, value_t omega = 0, size_t threads = 0);
+        // Simple iteration with Chebyshev parameters, in a stable order, the
+        // set repeating every `cycle` iterations (a power of two)
+        step_t chebyshevParams(const EllipticProblem &problem, size_t cycle);
+        step_t alternatingTriangles(const EllipticProblem &problem);
+        // The same with Chebyshev parameters over a `cycle` of iterations
+        step_t alternatingTrianglesChebyshev(const EllipticProblem &problem, size_t cycle);
+        // Peaceman-Rachford, with the parameter optimal for a single step
+        step_t alternatingDirections(const EllipticProblem &problem);
+        // Geometric multigrid V-cycles. The grid is halved while n and m are
+        // both even, the coarser operators averaging the couplings of the
+        // finer ones, and the coarsest grid is solved directly, so it should
+        // have at most about a thousand inner nodes. Each level makes
+        // `smoothing` red-black Seidel sweeps before and after the correction
+        // from the next one, which gets the residual by full weighting and
+        // gives the correction back by bilinear interpolation. The
+        // convergence rate doesn't depend on the grid size.
+        step_t multigrid(const EllipticProblem &problem, size_t smoothing = 2, size_t threads = 0);
+    } // namespace solveUsing
 } // namespace pde